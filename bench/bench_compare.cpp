@@ -0,0 +1,521 @@
+/*****************************************************************************
+ * @file    bench_compare.cpp
+ * @author  Kshitij Mistry
+ * @brief   Side-by-side comparison of the ring buffer with reference queues.
+ *
+ * The same workloads run against every queue: SPSC with 64 B messages, MPSC with four producers and 64 B
+ * messages, and a byte stream of variable sized messages between 16 B and 4000 B from one producer. The
+ * reference queues are built in this file: a std::deque guarded by a std::mutex, a textbook Lamport SPSC
+ * ring on C++11 atomics and a pipe. The ring buffer is not thread safe, so its rows take a std::mutex around
+ * every call, which is how an application has to share a buffer between threads today.
+ *
+ * Every message carries its send time. The consumer reports throughput and the latency percentiles from
+ * send to receive; the producers run flat out, so latency includes the time a message waits in a full queue
+ * and grows with the queue capacity. All queues hold about 1000 messages.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "ringBuffer.h"
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** Size of the ring buffer under test, large enough that the record index is the only limit */
+#define BENCH_BUFFER_BYTES (8 * 1024 * 1024)
+
+/** Records kept in the ring buffer at most, below its record index limit of 998 */
+#define RB_RECORD_LIMIT    (900)
+
+/** Capacity of the reference queues in messages */
+#define QUEUE_CAPACITY     (1024)
+
+/** Largest message of any workload, header included it stays below PIPE_BUF so pipe writes are atomic */
+#define MAX_MESSAGE_BYTES  (4000)
+
+/** Size of the length header of a pipe message */
+#define PIPE_HEADER_BYTES  (sizeof(cU32_t))
+
+/** Largest number of producer threads of any workload */
+#define MAX_PRODUCERS      (4)
+
+/*****************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+typedef struct
+{
+    const char *name;           /**< Workload name in the report */
+    cU32_t      producerCnt;    /**< Number of producer threads */
+    cU64_t      messageCnt;     /**< Messages sent over all producers */
+    cU64_t      minBytes;       /**< Smallest message size in bytes */
+    cU64_t      maxBytes;       /**< Largest message size in bytes */
+
+} Bench_Workload_t;
+
+typedef struct
+{
+    double msgPerSec;           /**< Messages per second */
+    double mbPerSec;            /**< Payload megabytes per second */
+    cU64_t p50Ns;               /**< Median send to receive latency */
+    cU64_t p99Ns;               /**< 99th percentile send to receive latency */
+    cU64_t maxNs;               /**< Largest send to receive latency */
+
+} Bench_Result_t;
+
+/*****************************************************************************
+ * STRUCTURES
+ *****************************************************************************/
+/**
+ * @brief Queue under test. push and pop return false instead of blocking, the caller retries.
+ */
+class Bench_Queue
+{
+public:
+    virtual ~Bench_Queue() {}
+
+    virtual const char *name() const = 0;
+
+    virtual bool multiProducer() const = 0;
+
+    virtual bool push(const cU8_t *data, cU64_t dataBytes) = 0;
+
+    virtual bool pop(cU8_t *outBuf, cU64_t *dataBytes) = 0;
+};
+
+/**
+ * @brief Ring buffer of this library, serialized by a mutex.
+ */
+class Bench_RbQueue : public Bench_Queue
+{
+public:
+    Bench_RbQueue() : bufferHandle(-1)
+    {
+        Rb_CreateBuffer(BENCH_BUFFER_BYTES, &bufferHandle);
+    }
+
+    ~Bench_RbQueue()
+    {
+        Rb_DestroyBuffer(&bufferHandle);
+    }
+
+    const char *name() const { return "lib-buffer+mutex"; }
+
+    bool multiProducer() const { return true; }
+
+    bool push(const cU8_t *data, cU64_t dataBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Check the record limit first, a write to a full buffer fails with an error print
+        if (Rb_GetUnreadIndexCount(bufferHandle) >= RB_RECORD_LIMIT)
+        {
+            return false;
+        }
+
+        return (Rb_WriteToBuffer(bufferHandle, data, dataBytes) == c_TRUE);
+    }
+
+    bool pop(cU8_t *outBuf, cU64_t *dataBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (Rb_GetUnreadIndexCount(bufferHandle) == 0)
+        {
+            return false;
+        }
+
+        return (Rb_ReadToBuffer(bufferHandle, outBuf, MAX_MESSAGE_BYTES, dataBytes) == c_TRUE);
+    }
+
+private:
+    std::mutex mutex;           /**< Serializes all calls on the buffer */
+    cI32_t     bufferHandle;    /**< Buffer under test */
+};
+
+/**
+ * @brief Bounded std::deque of messages guarded by a mutex, one heap allocation per message.
+ */
+class Bench_DequeQueue : public Bench_Queue
+{
+public:
+    const char *name() const { return "mutex+deque"; }
+
+    bool multiProducer() const { return true; }
+
+    bool push(const cU8_t *data, cU64_t dataBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (queue.size() >= QUEUE_CAPACITY)
+        {
+            return false;
+        }
+
+        queue.emplace_back(data, data + dataBytes);
+        return true;
+    }
+
+    bool pop(cU8_t *outBuf, cU64_t *dataBytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (queue.empty())
+        {
+            return false;
+        }
+
+        *dataBytes = queue.front().size();
+        memcpy(outBuf, queue.front().data(), *dataBytes);
+        queue.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex                       mutex;    /**< Guards the queue */
+    std::deque<std::vector<cU8_t> >  queue;    /**< Messages in arrival order */
+};
+
+/**
+ * @brief Lamport single producer single consumer ring of fixed size slots.
+ */
+class Bench_LamportQueue : public Bench_Queue
+{
+public:
+    Bench_LamportQueue() : slots(QUEUE_CAPACITY), head(0), tail(0) {}
+
+    const char *name() const { return "lamport-spsc"; }
+
+    bool multiProducer() const { return false; }
+
+    bool push(const cU8_t *data, cU64_t dataBytes)
+    {
+        cU64_t writeIndex = tail.load(std::memory_order_relaxed);
+
+        if ((writeIndex - head.load(std::memory_order_acquire)) == QUEUE_CAPACITY)
+        {
+            return false;
+        }
+
+        Slot &slot = slots[writeIndex % QUEUE_CAPACITY];
+        slot.dataBytes = dataBytes;
+        memcpy(slot.data, data, dataBytes);
+        tail.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(cU8_t *outBuf, cU64_t *dataBytes)
+    {
+        cU64_t readIndex = head.load(std::memory_order_relaxed);
+
+        if (readIndex == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        const Slot &slot = slots[readIndex % QUEUE_CAPACITY];
+        *dataBytes = slot.dataBytes;
+        memcpy(outBuf, slot.data, slot.dataBytes);
+        head.store(readIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        cU64_t dataBytes;                   /**< Size of the message in the slot */
+        cU8_t  data[MAX_MESSAGE_BYTES];     /**< Message bytes */
+    };
+
+    std::vector<Slot>                 slots;    /**< Message slots */
+    alignas(64) std::atomic<cU64_t>   head;     /**< Next slot to read, written by the consumer */
+    alignas(64) std::atomic<cU64_t>   tail;     /**< Next slot to write, written by the producer */
+};
+
+/**
+ * @brief Pipe carrying length prefixed messages. Writes up to PIPE_BUF bytes are atomic, so several
+ *        producers may share it.
+ */
+class Bench_PipeQueue : public Bench_Queue
+{
+public:
+    Bench_PipeQueue()
+    {
+        pipeFd[0] = -1;
+        pipeFd[1] = -1;
+        if (pipe(pipeFd) == 0)
+        {
+            // Only the write end is non-blocking, the reader blocks in the middle of a message
+            fcntl(pipeFd[1], F_SETFL, O_NONBLOCK);
+        }
+    }
+
+    ~Bench_PipeQueue()
+    {
+        close(pipeFd[0]);
+        close(pipeFd[1]);
+    }
+
+    const char *name() const { return "pipe"; }
+
+    bool multiProducer() const { return true; }
+
+    bool push(const cU8_t *data, cU64_t dataBytes)
+    {
+        cU8_t  message[PIPE_HEADER_BYTES + MAX_MESSAGE_BYTES];
+        cU32_t header = (cU32_t)dataBytes;
+
+        memcpy(message, &header, PIPE_HEADER_BYTES);
+        memcpy(message + PIPE_HEADER_BYTES, data, dataBytes);
+
+        // A non-blocking write of at most PIPE_BUF bytes is either complete or fails with EAGAIN
+        return (write(pipeFd[1], message, PIPE_HEADER_BYTES + dataBytes) > 0);
+    }
+
+    bool pop(cU8_t *outBuf, cU64_t *dataBytes)
+    {
+        cU32_t header;
+
+        if ((readFull((cU8_t *)&header, PIPE_HEADER_BYTES) == false) || (readFull(outBuf, header) == false))
+        {
+            return false;
+        }
+
+        *dataBytes = header;
+        return true;
+    }
+
+private:
+    bool readFull(cU8_t *outBuf, cU64_t dataBytes)
+    {
+        cU64_t  doneBytes = 0;
+        ssize_t readBytes;
+
+        while (doneBytes < dataBytes)
+        {
+            readBytes = read(pipeFd[0], outBuf + doneBytes, dataBytes - doneBytes);
+            if (readBytes <= 0)
+            {
+                return false;
+            }
+            doneBytes += (cU64_t)readBytes;
+        }
+
+        return true;
+    }
+
+    int pipeFd[2];  /**< Read and write end of the pipe */
+};
+
+/*****************************************************************************
+ * VARIABLES
+ *****************************************************************************/
+static const Bench_Workload_t gWorkloads[] = {
+    {"spsc-64B", 1, 1000000, 64, 64},
+    {"mpsc4-64B", MAX_PRODUCERS, 1000000, 64, 64},
+    {"stream-16B..4000B", 1, 200000, 16, MAX_MESSAGE_BYTES},
+};
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+static Bench_Queue *createQueue(cU32_t queueId);
+
+static void runProducer(Bench_Queue *queue, const Bench_Workload_t *workload, cU32_t producerId,
+                        std::atomic<bool> *startF);
+
+static bool runWorkload(Bench_Queue *queue, const Bench_Workload_t *workload, Bench_Result_t *result);
+
+static cU64_t nextRandom(cU64_t *state);
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Run every workload against every queue and print one table.
+ * @return int Returns 0.
+ */
+int main(void)
+{
+    Bench_Result_t result;
+    Bench_Queue   *queue;
+    cU32_t         workloadId, queueId;
+
+    Rb_InitModule();
+
+    printf("%-18s %-17s %12s %10s %10s %10s %10s\n", "workload", "queue", "msg/s", "MB/s", "p50 ns", "p99 ns",
+           "max ns");
+
+    for (workloadId = 0; workloadId < (sizeof(gWorkloads) / sizeof(gWorkloads[0])); workloadId++)
+    {
+        for (queueId = 0; (queue = createQueue(queueId)) != NULL; queueId++)
+        {
+            if ((gWorkloads[workloadId].producerCnt > 1) && (queue->multiProducer() == false))
+            {
+                printf("%-18s %-17s %12s %10s %10s %10s %10s\n", gWorkloads[workloadId].name, queue->name(), "n/a",
+                       "n/a", "n/a", "n/a", "n/a");
+            }
+            else if (runWorkload(queue, &gWorkloads[workloadId], &result) == true)
+            {
+                printf("%-18s %-17s %12.0f %10.1f %10lu %10lu %10lu\n", gWorkloads[workloadId].name, queue->name(),
+                       result.msgPerSec, result.mbPerSec, result.p50Ns, result.p99Ns, result.maxNs);
+            }
+            else
+            {
+                printf("%-18s %-17s failed\n", gWorkloads[workloadId].name, queue->name());
+            }
+
+            delete queue;
+        }
+    }
+
+    Rb_DeinitModule();
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Create the queue with the given position in the report.
+ * @param queueId Position of the queue in the report.
+ * @return Bench_Queue* Returns the queue, or NULL past the last queue.
+ */
+static Bench_Queue *createQueue(cU32_t queueId)
+{
+    switch (queueId)
+    {
+        case 0:
+            return new Bench_RbQueue();
+        case 1:
+            return new Bench_DequeQueue();
+        case 2:
+            return new Bench_LamportQueue();
+        case 3:
+            return new Bench_PipeQueue();
+        default:
+            return NULL;
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Send this producer's share of the workload, each message starting with its send time.
+ * @param queue Queue under test.
+ * @param workload Workload to run.
+ * @param producerId Index of the producer, seeds the message sizes.
+ * @param startF Flag raised when all threads are ready.
+ */
+static void runProducer(Bench_Queue *queue, const Bench_Workload_t *workload, cU32_t producerId,
+                        std::atomic<bool> *startF)
+{
+    cU8_t  message[MAX_MESSAGE_BYTES];
+    cU64_t messageId, messageBytes, sendTimeNs;
+    cU64_t randomState = 0x9e3779b97f4a7c15ULL * (producerId + 1);
+
+    memset(message, 0x5a, sizeof(message));
+    while (startF->load(std::memory_order_acquire) == false)
+    {
+    }
+
+    for (messageId = 0; messageId < (workload->messageCnt / workload->producerCnt); messageId++)
+    {
+        messageBytes = workload->minBytes + (nextRandom(&randomState) % (workload->maxBytes - workload->minBytes + 1));
+        sendTimeNs = Rb_GetTimeNs();
+        memcpy(message, &sendTimeNs, sizeof(sendTimeNs));
+
+        while (queue->push(message, messageBytes) == false)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Run one workload against one queue, consuming on the calling thread.
+ * @param queue Queue under test.
+ * @param workload Workload to run.
+ * @param result Pointer to store the throughput and latency.
+ * @return bool Returns true if all messages were received, otherwise false.
+ */
+static bool runWorkload(Bench_Queue *queue, const Bench_Workload_t *workload, Bench_Result_t *result)
+{
+    std::vector<std::thread> producers;
+    std::vector<cU64_t>      latencyNs;
+    std::atomic<bool>        startF(false);
+    cU8_t                    message[MAX_MESSAGE_BYTES];
+    cU64_t                   messageCnt = (workload->messageCnt / workload->producerCnt) * workload->producerCnt;
+    cU64_t                   receivedCnt = 0, receivedBytes = 0, dataBytes, sendTimeNs, startNs, elapsedNs;
+    cU32_t                   producerId;
+
+    latencyNs.reserve(messageCnt);
+    for (producerId = 0; producerId < workload->producerCnt; producerId++)
+    {
+        producers.emplace_back(runProducer, queue, workload, producerId, &startF);
+    }
+
+    startNs = Rb_GetTimeNs();
+    startF.store(true, std::memory_order_release);
+
+    while (receivedCnt < messageCnt)
+    {
+        if (queue->pop(message, &dataBytes) == false)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        memcpy(&sendTimeNs, message, sizeof(sendTimeNs));
+        latencyNs.push_back(Rb_GetTimeNs() - sendTimeNs);
+        receivedBytes += dataBytes;
+        receivedCnt++;
+    }
+
+    elapsedNs = Rb_GetTimeNs() - startNs;
+    for (producerId = 0; producerId < workload->producerCnt; producerId++)
+    {
+        producers[producerId].join();
+    }
+
+    if (latencyNs.empty() == true)
+    {
+        return false;
+    }
+
+    std::sort(latencyNs.begin(), latencyNs.end());
+    result->msgPerSec = (double)receivedCnt * 1e9 / (double)elapsedNs;
+    result->mbPerSec = (double)receivedBytes * 1e3 / (double)elapsedNs;
+    result->p50Ns = latencyNs[latencyNs.size() / 2];
+    result->p99Ns = latencyNs[(latencyNs.size() * 99) / 100];
+    result->maxNs = latencyNs.back();
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Advance a xorshift generator, used for repeatable message sizes.
+ * @param state Pointer to the generator state.
+ * @return cU64_t Returns the next random value.
+ */
+static cU64_t nextRandom(cU64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
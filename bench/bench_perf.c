@@ -0,0 +1,488 @@
+/*****************************************************************************
+ * @file    bench_perf.c
+ * @author  Kshitij Mistry
+ * @brief   Microarchitectural profile of the data path using hardware performance counters.
+ *
+ * Every Rb_WriteToBuffer, Rb_PeekRead and Rb_CommitRead call is wrapped by enabling and disabling a
+ * perf_event_open counter group (cycles, instructions, L1D read misses, LLC misses, branch misses), so the
+ * report shows per-operation counts and tells whether a change helps through fewer instructions or fewer
+ * misses. The cost of an empty enable/disable pair is measured first and subtracted. Toggling the counters
+ * enters the kernel, so miss counts are an upper bound; the prefetch sweep at the end runs without counters
+ * and reports wall-clock time per record on cold data for record sizes between 64 B and 4 KB.
+ *
+ * Counters need perf_event_paranoid <= 2 (or CAP_PERFMON). Counters that cannot be opened are reported as
+ * "n/a" and the wall-clock numbers are still printed.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "ringBuffer.h"
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** Number of hardware counters in the group */
+#define COUNTER_CNT        (5)
+
+/** Size of the ring buffer under test */
+#define BENCH_BUFFER_BYTES (8 * 1024 * 1024)
+
+/** Records written and drained per round, the record index of a buffer holds up to 998 records */
+#define RECORDS_PER_ROUND  (900)
+
+/** Rounds per scenario */
+#define ROUNDS             (40)
+
+/** Rounds used to calibrate the counter toggle cost */
+#define CALIBRATE_ROUNDS   (20000)
+
+/** Size of the memory touched to evict the buffer from the caches between fill and drain */
+#define EVICT_BYTES        (64 * 1024 * 1024)
+
+/** L1 data cache read miss event */
+#define L1D_READ_MISS_CONFIG                                                                       \
+    (PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/*****************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+typedef struct
+{
+    cU32_t      type;    /**< perf event type */
+    cU64_t      config;  /**< perf event config */
+    const char *name;    /**< Column name in the report */
+
+} Bench_CounterDef_t;
+
+typedef struct
+{
+    cI32_t leaderFd;                /**< Group leader, -1 if no counter could be opened */
+    cI32_t counterFd[COUNTER_CNT];  /**< File descriptor of each counter, -1 if unavailable */
+    cU32_t openCnt;                 /**< Number of counters in the group */
+
+} Bench_Counters_t;
+
+typedef struct
+{
+    cU64_t value[COUNTER_CNT];      /**< Accumulated count of each counter */
+    cU64_t ops;                     /**< Number of measured operations */
+
+} Bench_Sample_t;
+
+/*****************************************************************************
+ * VARIABLES
+ *****************************************************************************/
+static const Bench_CounterDef_t gCounterDef[COUNTER_CNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instr"},
+    {PERF_TYPE_HW_CACHE, L1D_READ_MISS_CONFIG, "l1d-miss"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "llc-miss"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "br-miss"},
+};
+
+static const cU64_t gRecordSizes[] = {64, 256, 1024, 4096}; /**< Record sizes of the sweep */
+
+static const cU32_t gPrefetchDepths[] = {0, 2, 4, 8}; /**< Prefetch depths of the sweep */
+
+static Bench_Counters_t gCounters; /**< Counter group shared by all scenarios */
+
+static Bench_Sample_t gToggleCost; /**< Counts of an empty enable/disable pair */
+
+static cU8_t *gEvictMem; /**< Memory touched to evict the caches */
+
+static volatile cU64_t gSink; /**< Keeps the payload reads from being optimized out */
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+static void openCounters(Bench_Counters_t *counters);
+
+static void closeCounters(Bench_Counters_t *counters);
+
+static inline void startCounters(void);
+
+static inline void stopCounters(Bench_Sample_t *sample);
+
+static void calibrateCounters(void);
+
+static void evictCaches(void);
+
+static cU64_t touchPayload(const cU8_t *data, cU64_t dataBytes);
+
+static void profileDataPath(cU64_t recordBytes, cU32_t prefetchDepth);
+
+static cU64_t measureDrainNs(cU64_t recordBytes, cU32_t prefetchDepth);
+
+static void printSample(const char *opName, cU64_t recordBytes, cU32_t prefetchDepth, const Bench_Sample_t *sample);
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Run the counter profile and the prefetch sweep for all record sizes.
+ * @return int Returns 0 on success, 1 if the benchmark could not be set up.
+ */
+int main(void)
+{
+    cU32_t sizeId, depthId, counterId;
+
+    Rb_InitModule();
+
+    gEvictMem = (cU8_t *)malloc(EVICT_BYTES);
+    if (gEvictMem == NULL)
+    {
+        fprintf(stderr, "failed to allocate eviction memory\n");
+        return 1;
+    }
+
+    openCounters(&gCounters);
+    calibrateCounters();
+
+    printf("per-operation counters (toggle cost subtracted)\n");
+    printf("%-8s %6s %5s", "op", "bytes", "pf");
+    for (counterId = 0; counterId < COUNTER_CNT; counterId++)
+    {
+        printf(" %10s", gCounterDef[counterId].name);
+    }
+    printf("\n");
+
+    for (sizeId = 0; sizeId < (sizeof(gRecordSizes) / sizeof(gRecordSizes[0])); sizeId++)
+    {
+        profileDataPath(gRecordSizes[sizeId], 0);
+        profileDataPath(gRecordSizes[sizeId], 4);
+    }
+
+    printf("\nprefetch sweep: ns per record, cold data, peek + read payload + commit\n");
+    printf("%6s", "bytes");
+    for (depthId = 0; depthId < (sizeof(gPrefetchDepths) / sizeof(gPrefetchDepths[0])); depthId++)
+    {
+        printf("   depth %-2u", gPrefetchDepths[depthId]);
+    }
+    printf("\n");
+
+    for (sizeId = 0; sizeId < (sizeof(gRecordSizes) / sizeof(gRecordSizes[0])); sizeId++)
+    {
+        printf("%6lu", gRecordSizes[sizeId]);
+        for (depthId = 0; depthId < (sizeof(gPrefetchDepths) / sizeof(gPrefetchDepths[0])); depthId++)
+        {
+            printf(" %10.1f",
+                   (double)measureDrainNs(gRecordSizes[sizeId], gPrefetchDepths[depthId]) / (RECORDS_PER_ROUND * ROUNDS));
+        }
+        printf("\n");
+    }
+
+    closeCounters(&gCounters);
+    free(gEvictMem);
+    Rb_DeinitModule();
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Open the counter group, skipping counters the CPU or the kernel does not provide.
+ * @param counters Pointer to the counter group.
+ */
+static void openCounters(Bench_Counters_t *counters)
+{
+    struct perf_event_attr attr;
+    cU32_t                 counterId;
+
+    counters->leaderFd = -1;
+    counters->openCnt = 0;
+
+    for (counterId = 0; counterId < COUNTER_CNT; counterId++)
+    {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = gCounterDef[counterId].type;
+        attr.config = gCounterDef[counterId].config;
+        attr.disabled = (counters->leaderFd == -1) ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+
+        counters->counterFd[counterId] = (cI32_t)syscall(__NR_perf_event_open, &attr, 0, -1, counters->leaderFd, 0);
+        if (counters->counterFd[counterId] < 0)
+        {
+            fprintf(stderr, "counter %s not available\n", gCounterDef[counterId].name);
+            counters->counterFd[counterId] = -1;
+            continue;
+        }
+
+        if (counters->leaderFd == -1)
+        {
+            counters->leaderFd = counters->counterFd[counterId];
+        }
+
+        counters->openCnt++;
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Close all counters of the group.
+ * @param counters Pointer to the counter group.
+ */
+static void closeCounters(Bench_Counters_t *counters)
+{
+    cU32_t counterId;
+
+    for (counterId = 0; counterId < COUNTER_CNT; counterId++)
+    {
+        if (counters->counterFd[counterId] != -1)
+        {
+            close(counters->counterFd[counterId]);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Reset and enable the counter group.
+ */
+static inline void startCounters(void)
+{
+    if (gCounters.leaderFd != -1)
+    {
+        ioctl(gCounters.leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(gCounters.leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Disable the counter group and add its counts to the sample.
+ * @param sample Pointer to the sample to accumulate into.
+ */
+static inline void stopCounters(Bench_Sample_t *sample)
+{
+    cU64_t groupData[1 + COUNTER_CNT];
+    cU32_t counterId, valueId = 0;
+
+    sample->ops++;
+    if (gCounters.leaderFd == -1)
+    {
+        return;
+    }
+
+    ioctl(gCounters.leaderFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (read(gCounters.leaderFd, groupData, sizeof(groupData)) <= 0)
+    {
+        return;
+    }
+
+    // Group data holds the number of counters followed by their values in opening order
+    for (counterId = 0; counterId < COUNTER_CNT; counterId++)
+    {
+        if (gCounters.counterFd[counterId] != -1)
+        {
+            sample->value[counterId] += groupData[1 + valueId++];
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Measure the counts of an empty enable/disable pair, subtracted from every operation.
+ */
+static void calibrateCounters(void)
+{
+    cU32_t roundId;
+
+    memset(&gToggleCost, 0, sizeof(gToggleCost));
+    for (roundId = 0; roundId < CALIBRATE_ROUNDS; roundId++)
+    {
+        startCounters();
+        stopCounters(&gToggleCost);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Touch a memory area larger than the last level cache, so the buffer under test gets cold.
+ */
+static void evictCaches(void)
+{
+    cU64_t offset;
+
+    for (offset = 0; offset < EVICT_BYTES; offset += 64)
+    {
+        gEvictMem[offset]++;
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Read every cache line of the payload, as a consumer parsing the record would.
+ * @param data Pointer to the payload.
+ * @param dataBytes Size of the payload in bytes.
+ * @return cU64_t Returns a sum of the payload bytes.
+ */
+static cU64_t touchPayload(const cU8_t *data, cU64_t dataBytes)
+{
+    cU64_t offset, sum = 0;
+
+    for (offset = 0; offset < dataBytes; offset += 64)
+    {
+        sum += data[offset];
+    }
+
+    return sum;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Profile write, peek and commit one call at a time and print the per-operation counts.
+ * @param recordBytes Size of each record in bytes.
+ * @param prefetchDepth Read prefetch depth of the buffer.
+ */
+static void profileDataPath(cU64_t recordBytes, cU32_t prefetchDepth)
+{
+    Bench_Sample_t writeSample, peekSample, commitSample;
+    cU8_t         *record, *readPtr;
+    cU64_t         dataBytes, sum = 0;
+    cI32_t         bufferHandle;
+    cU32_t         roundId, recordId;
+
+    memset(&writeSample, 0, sizeof(writeSample));
+    memset(&peekSample, 0, sizeof(peekSample));
+    memset(&commitSample, 0, sizeof(commitSample));
+
+    record = (cU8_t *)malloc(recordBytes);
+    if ((record == NULL) || (Rb_CreateBuffer(BENCH_BUFFER_BYTES, &bufferHandle) == c_FALSE))
+    {
+        fprintf(stderr, "failed to set up scenario\n");
+        free(record);
+        return;
+    }
+
+    memset(record, 0x5a, recordBytes);
+    Rb_SetPrefetchDepth(bufferHandle, prefetchDepth);
+
+    for (roundId = 0; roundId < ROUNDS; roundId++)
+    {
+        for (recordId = 0; recordId < RECORDS_PER_ROUND; recordId++)
+        {
+            startCounters();
+            Rb_WriteToBuffer(bufferHandle, record, recordBytes);
+            stopCounters(&writeSample);
+        }
+
+        evictCaches();
+
+        for (recordId = 0; recordId < RECORDS_PER_ROUND; recordId++)
+        {
+            startCounters();
+            Rb_PeekRead(bufferHandle, &readPtr, &dataBytes);
+            stopCounters(&peekSample);
+
+            sum += touchPayload(readPtr, dataBytes);
+
+            startCounters();
+            Rb_CommitRead(bufferHandle, dataBytes);
+            stopCounters(&commitSample);
+        }
+    }
+
+    gSink = sum;
+    printSample("write", recordBytes, prefetchDepth, &writeSample);
+    printSample("peek", recordBytes, prefetchDepth, &peekSample);
+    printSample("commit", recordBytes, prefetchDepth, &commitSample);
+
+    Rb_DestroyBuffer(&bufferHandle);
+    free(record);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Measure the wall-clock time to drain cold records, reading each payload, without counters.
+ * @param recordBytes Size of each record in bytes.
+ * @param prefetchDepth Read prefetch depth of the buffer.
+ * @return cU64_t Returns the total drain time in nanoseconds over all rounds.
+ */
+static cU64_t measureDrainNs(cU64_t recordBytes, cU32_t prefetchDepth)
+{
+    cU8_t *record, *readPtr;
+    cU64_t dataBytes, startNs, totalNs = 0, sum = 0;
+    cI32_t bufferHandle;
+    cU32_t roundId, recordId;
+
+    record = (cU8_t *)malloc(recordBytes);
+    if ((record == NULL) || (Rb_CreateBuffer(BENCH_BUFFER_BYTES, &bufferHandle) == c_FALSE))
+    {
+        fprintf(stderr, "failed to set up scenario\n");
+        free(record);
+        return 0;
+    }
+
+    memset(record, 0x5a, recordBytes);
+    Rb_SetPrefetchDepth(bufferHandle, prefetchDepth);
+
+    for (roundId = 0; roundId < ROUNDS; roundId++)
+    {
+        for (recordId = 0; recordId < RECORDS_PER_ROUND; recordId++)
+        {
+            Rb_WriteToBuffer(bufferHandle, record, recordBytes);
+        }
+
+        evictCaches();
+
+        startNs = Rb_GetTimeNs();
+        for (recordId = 0; recordId < RECORDS_PER_ROUND; recordId++)
+        {
+            Rb_PeekRead(bufferHandle, &readPtr, &dataBytes);
+            sum += touchPayload(readPtr, dataBytes);
+            Rb_CommitRead(bufferHandle, dataBytes);
+        }
+        totalNs += Rb_GetTimeNs() - startNs;
+    }
+
+    gSink = sum;
+    Rb_DestroyBuffer(&bufferHandle);
+    free(record);
+    return totalNs;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Print the average counts per operation of a sample, minus the toggle cost.
+ * @param opName Name of the operation.
+ * @param recordBytes Size of each record in bytes.
+ * @param prefetchDepth Read prefetch depth of the buffer.
+ * @param sample Pointer to the sample.
+ */
+static void printSample(const char *opName, cU64_t recordBytes, cU32_t prefetchDepth, const Bench_Sample_t *sample)
+{
+    cU32_t counterId;
+
+    printf("%-8s %6lu %5u", opName, recordBytes, prefetchDepth);
+    for (counterId = 0; counterId < COUNTER_CNT; counterId++)
+    {
+        double perOp, togglePerOp;
+
+        if ((gCounters.counterFd[counterId] == -1) || (sample->ops == 0))
+        {
+            printf(" %10s", "n/a");
+            continue;
+        }
+
+        perOp = (double)sample->value[counterId] / (double)sample->ops;
+        togglePerOp = (double)gToggleCost.value[counterId] / (double)gToggleCost.ops;
+        printf(" %10.1f", (perOp > togglePerOp) ? (perOp - togglePerOp) : 0.0);
+    }
+    printf("\n");
+}
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
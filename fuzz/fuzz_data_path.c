@@ -0,0 +1,649 @@
+/*****************************************************************************
+ * @file    fuzz_data_path.c
+ * @author  Kshitij Mistry
+ * @brief   Fuzz target for the record index and wrap logic of the data path.
+ *
+ * Each input is decoded into a sequence of write, peek, commit, copy read, wrap policy change, write group,
+ * tag filter, destroy and consistency check operations on one buffer. A reference model of the unread records runs alongside, and
+ * every record read back is compared with the model for size and content, so a wrong record length, a lost
+ * fragment or a reader left behind after a wrap aborts the run. Buffer sizes are small so most inputs reach
+ * the end of the buffer and the record index limit.
+ *
+ * Built with clang, LLVMFuzzerTestOneInput is driven by libFuzzer. With RB_FUZZ_REPLAY a main is added
+ * that replays corpus files (or a built-in generated corpus) through the same target, once to check for
+ * regressions or with -b to report operations per second, so a fix that slows the data path is noticed.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ringBuffer.h"
+
+#ifdef RB_FUZZ_REPLAY
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** Largest buffer used by the target, also the largest record */
+#define FUZZ_MAX_BUFFER_BYTES (4096)
+
+/** Records the model can hold, every record takes at least one byte of the buffer */
+#define FUZZ_MODEL_RECORDS    (FUZZ_MAX_BUFFER_BYTES)
+
+/** Abort with the failing operation, libFuzzer saves the input that got here */
+#define FUZZ_CHECK(cond)                                                                        \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(cond))                                                                            \
+        {                                                                                       \
+            fprintf(stderr, "fuzz check failed: %s [line=%d], [op=%lu]\n", #cond, __LINE__, gOpCnt); \
+            abort();                                                                            \
+        }                                                                                       \
+    } while (0)
+
+#ifdef RB_FUZZ_REPLAY
+/** Inputs of the built-in corpus used when no corpus is given */
+#define GEN_INPUT_CNT         (256)
+
+/** Size of each generated input */
+#define GEN_INPUT_BYTES       (4096)
+
+/** Replays of the corpus in benchmark mode */
+#define BENCH_ROUNDS          (20)
+#endif
+
+/*****************************************************************************
+ * ENUMS
+ *****************************************************************************/
+typedef enum
+{
+    Fuzz_Op_WRITE,          /**< Write a record of a size taken from the input */
+    Fuzz_Op_PEEK,           /**< Peek the next record */
+    Fuzz_Op_COMMIT,         /**< Commit the peeked record */
+    Fuzz_Op_READ_COPY,      /**< Read the next record into user memory */
+    Fuzz_Op_WRAP_POLICY,    /**< Change the wrap policy */
+    Fuzz_Op_RECREATE,       /**< Destroy the buffer and create one of a size taken from the input */
+    Fuzz_Op_CHECK,          /**< Check the internal consistency of the buffer */
+    Fuzz_Op_GROUP_BEGIN,    /**< Open a write group */
+    Fuzz_Op_GROUP_END,      /**< Publish or abort the open write group */
+    Fuzz_Op_TAG_FILTER,     /**< Subscribe the reader to a set of tags */
+    Fuzz_Op_CNT,
+
+} Fuzz_Op_e;
+
+/*****************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+typedef struct
+{
+    cU64_t dataBytes;       /**< Size of the record */
+    cU8_t  seed;            /**< First byte of the record, the following bytes are derived from it */
+    cU8_t  tag;             /**< Tag of the record */
+    cU32_t userWord;        /**< User word of the record, only tag 3 records carry one */
+
+} Fuzz_Record_t;
+
+typedef struct
+{
+    Fuzz_Record_t record[FUZZ_MODEL_RECORDS];   /**< Unread records in write order */
+    cU64_t        head;                         /**< Position of the oldest unread record */
+    cU64_t        count;                        /**< Number of unread published records */
+    cU64_t        groupCount;                   /**< Number of records written to the open write group */
+    cBool         groupOpenF;                   /**< Flag to indicate a write group is open */
+    cU64_t        tagFilter;                    /**< Tags served to the reader */
+    cU64_t        bufferBytes;                  /**< Size of the buffer under test */
+    cI32_t        bufferHandle;                 /**< Buffer under test */
+    cBool         peekedF;                      /**< Flag to indicate a peek is outstanding */
+    cU64_t        peekedBytes;                  /**< Size returned by the outstanding peek */
+
+} Fuzz_Model_t;
+
+/*****************************************************************************
+ * VARIABLES
+ *****************************************************************************/
+static const cU64_t gBufferSizes[] = {61, 256, 1000, FUZZ_MAX_BUFFER_BYTES}; /**< Sizes of the buffer */
+
+static Fuzz_Model_t gModel; /**< Reference model of the buffer under test */
+
+static cU8_t gRecordData[FUZZ_MAX_BUFFER_BYTES]; /**< Record being written */
+
+static cU8_t gReadData[FUZZ_MAX_BUFFER_BYTES]; /**< Record read by copy */
+
+static cU64_t gOpCnt; /**< Operations executed since start */
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+int LLVMFuzzerTestOneInput(const cU8_t *data, cSize_t size);
+
+static void createBuffer(cU8_t sizeSelector);
+
+static void fillRecord(cU8_t seed, cU64_t dataBytes);
+
+static void checkRecord(const cU8_t *readPtr, cU64_t dataBytes);
+
+static void popRecord(void);
+
+static cBool findServedRecord(void);
+
+static void runOp(Fuzz_Op_e op, const cU8_t *arg);
+
+#ifdef RB_FUZZ_REPLAY
+static cBool loadFile(const char *path, cU8_t **data, cSize_t *size);
+
+static cU64_t replayPath(const char *path);
+
+static void replayGenerated(void);
+#endif
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Run one input: every 3 bytes are an operation and two argument bytes.
+ * @param data Input bytes.
+ * @param size Size of the input in bytes.
+ * @return int Returns 0, failures abort.
+ */
+int LLVMFuzzerTestOneInput(const cU8_t *data, cSize_t size)
+{
+    static cBool initF = c_FALSE;
+    cSize_t      offset;
+
+    if (initF == c_FALSE)
+    {
+        Rb_InitModule();
+        initF = c_TRUE;
+    }
+
+    createBuffer((size > 0) ? data[0] : 0);
+
+    for (offset = 1; (offset + 3) <= size; offset += 3)
+    {
+        runOp((Fuzz_Op_e)(data[offset] % Fuzz_Op_CNT), &data[offset + 1]);
+    }
+
+    // Everything the model holds must still be readable in order
+    if (gModel.groupOpenF == c_TRUE)
+    {
+        runOp(Fuzz_Op_GROUP_END, (const cU8_t *)"\1\0");
+    }
+
+    if (gModel.peekedF == c_TRUE)
+    {
+        runOp(Fuzz_Op_COMMIT, NULL);
+    }
+
+    FUZZ_CHECK(Rb_SetTagFilter(gModel.bufferHandle, ~0ULL) == c_TRUE);
+    gModel.tagFilter = ~0ULL;
+
+    while (gModel.count > 0)
+    {
+        runOp(Fuzz_Op_READ_COPY, NULL);
+    }
+
+    FUZZ_CHECK(Rb_GetUnreadIndexCount(gModel.bufferHandle) == 0);
+    FUZZ_CHECK(Rb_DestroyBuffer(&gModel.bufferHandle) == c_TRUE);
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Create the buffer under test and empty the model.
+ * @param sizeSelector Input byte selecting the buffer size, wrap policy and compaction.
+ */
+static void createBuffer(cU8_t sizeSelector)
+{
+    gModel.bufferBytes = gBufferSizes[sizeSelector % (sizeof(gBufferSizes) / sizeof(gBufferSizes[0]))];
+    gModel.head = 0;
+    gModel.count = 0;
+    gModel.groupCount = 0;
+    gModel.groupOpenF = c_FALSE;
+    gModel.tagFilter = ~0ULL;
+    gModel.peekedF = c_FALSE;
+
+    FUZZ_CHECK(Rb_CreateBuffer(gModel.bufferBytes, &gModel.bufferHandle) == c_TRUE);
+    FUZZ_CHECK(Rb_SetWrapPolicy(gModel.bufferHandle, (sizeSelector & 0x80) ? Rb_WrapPolicy_PAD : Rb_WrapPolicy_SPLIT) ==
+               c_TRUE);
+    FUZZ_CHECK(Rb_SetCompactOnEmpty(gModel.bufferHandle, (sizeSelector & 0x40) ? c_FALSE : c_TRUE) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Fill the record being written with bytes derived from the seed.
+ * @param seed First byte of the record.
+ * @param dataBytes Size of the record in bytes.
+ */
+static void fillRecord(cU8_t seed, cU64_t dataBytes)
+{
+    cU64_t byteId;
+
+    for (byteId = 0; byteId < dataBytes; byteId++)
+    {
+        gRecordData[byteId] = (cU8_t)(seed + (byteId * 31));
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Compare a record read from the buffer with the oldest record of the model.
+ * @param readPtr Pointer to the record.
+ * @param dataBytes Size of the record in bytes.
+ */
+static void checkRecord(const cU8_t *readPtr, cU64_t dataBytes)
+{
+    const Fuzz_Record_t *record = &gModel.record[gModel.head];
+    cU64_t               byteId;
+
+    FUZZ_CHECK(gModel.count > 0);
+    FUZZ_CHECK(dataBytes == record->dataBytes);
+
+    for (byteId = 0; byteId < dataBytes; byteId++)
+    {
+        FUZZ_CHECK(readPtr[byteId] == (cU8_t)(record->seed + (byteId * 31)));
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Remove the oldest record from the model.
+ */
+static void popRecord(void)
+{
+    gModel.head = (gModel.head + 1) % FUZZ_MODEL_RECORDS;
+    gModel.count--;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Drop the records the tag filter skips from the model, as the next peek does in the buffer.
+ * @return cBool Returns c_TRUE if a served record follows them, otherwise c_FALSE and the model is unchanged,
+ *         since the buffer skips only when a peek is made.
+ */
+static cBool findServedRecord(void)
+{
+    cU64_t recordId;
+
+    for (recordId = 0; recordId < gModel.count; recordId++)
+    {
+        if (gModel.tagFilter & (1ULL << gModel.record[(gModel.head + recordId) % FUZZ_MODEL_RECORDS].tag))
+        {
+            while (recordId-- > 0)
+            {
+                popRecord();
+            }
+            return c_TRUE;
+        }
+    }
+
+    return c_FALSE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Run one operation on the buffer and the model. Operations the library rejects with an error print
+ *        (peek with a peek outstanding, commit without a peek) are skipped, a write is always attempted.
+ * @param op Operation to run.
+ * @param arg Two argument bytes, NULL for operations that take none.
+ */
+static void runOp(Fuzz_Op_e op, const cU8_t *arg)
+{
+    Fuzz_Record_t *record;
+    cU8_t         *readPtr;
+    cU64_t         dataBytes;
+    cBool          status;
+    cU32_t         userWord;
+    cU8_t          tag;
+
+    gOpCnt++;
+
+    switch (op)
+    {
+        case Fuzz_Op_WRITE:
+            dataBytes = 1 + ((((cU64_t)arg[0] << 8) | arg[1]) % gModel.bufferBytes);
+            tag = (arg[0] >> 4) & 0x03;
+            userWord = (tag == 3) ? (arg[1] * 0x01010101U) : 0;
+            fillRecord(arg[1], dataBytes);
+            if (tag == 3)
+            {
+                status = Rb_WriteTaggedToLane(gModel.bufferHandle, 0, tag, userWord, gRecordData, dataBytes);
+            }
+            else
+            {
+                status = (tag == 0) ? Rb_WriteToBuffer(gModel.bufferHandle, gRecordData, dataBytes)
+                                    : Rb_WriteTaggedToBuffer(gModel.bufferHandle, tag, gRecordData, dataBytes);
+            }
+
+            // An empty buffer takes any record up to half of its size
+            if (((gModel.count + gModel.groupCount) == 0) && (dataBytes <= (gModel.bufferBytes / 2)))
+            {
+                FUZZ_CHECK(status == c_TRUE);
+            }
+
+            if (status == c_TRUE)
+            {
+                // Records of an open group are kept after the published ones
+                FUZZ_CHECK((gModel.count + gModel.groupCount) < FUZZ_MODEL_RECORDS);
+                record = &gModel.record[(gModel.head + gModel.count + gModel.groupCount) % FUZZ_MODEL_RECORDS];
+                record->dataBytes = dataBytes;
+                record->seed = arg[1];
+                record->tag = tag;
+                record->userWord = userWord;
+
+                if (gModel.groupOpenF == c_TRUE)
+                {
+                    gModel.groupCount++;
+                }
+                else
+                {
+                    gModel.count++;
+                }
+            }
+            break;
+
+        case Fuzz_Op_PEEK:
+            if ((gModel.peekedF == c_TRUE) || (findServedRecord() == c_FALSE))
+            {
+                break;
+            }
+
+            FUZZ_CHECK(Rb_PeekRead(gModel.bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+            FUZZ_CHECK(Rb_GetPeekTag(gModel.bufferHandle, &tag) == c_TRUE);
+            FUZZ_CHECK(tag == gModel.record[gModel.head].tag);
+            FUZZ_CHECK(Rb_GetPeekUserWord(gModel.bufferHandle, &userWord) == c_TRUE);
+            FUZZ_CHECK(userWord == gModel.record[gModel.head].userWord);
+            checkRecord(readPtr, dataBytes);
+            gModel.peekedF = c_TRUE;
+            gModel.peekedBytes = dataBytes;
+            break;
+
+        case Fuzz_Op_COMMIT:
+            if (gModel.peekedF == c_FALSE)
+            {
+                break;
+            }
+
+            FUZZ_CHECK(Rb_CommitRead(gModel.bufferHandle, gModel.peekedBytes) == c_TRUE);
+            gModel.peekedF = c_FALSE;
+            popRecord();
+            break;
+
+        case Fuzz_Op_READ_COPY:
+            if ((gModel.peekedF == c_TRUE) || (findServedRecord() == c_FALSE))
+            {
+                break;
+            }
+
+            FUZZ_CHECK(Rb_ReadToBuffer(gModel.bufferHandle, gReadData, sizeof(gReadData), &dataBytes) == c_TRUE);
+            checkRecord(gReadData, dataBytes);
+            popRecord();
+            break;
+
+        case Fuzz_Op_WRAP_POLICY:
+            FUZZ_CHECK(Rb_SetWrapPolicy(gModel.bufferHandle, (arg[0] & 1) ? Rb_WrapPolicy_PAD : Rb_WrapPolicy_SPLIT) ==
+                       c_TRUE);
+            break;
+
+        case Fuzz_Op_RECREATE:
+            if (gModel.groupOpenF == c_TRUE)
+            {
+                break;
+            }
+
+            FUZZ_CHECK(Rb_DestroyBuffer(&gModel.bufferHandle) == c_TRUE);
+            createBuffer(arg[0]);
+            break;
+
+        case Fuzz_Op_CHECK:
+            FUZZ_CHECK(Rb_CheckConsistency(gModel.bufferHandle) == c_TRUE);
+
+            // Records of an open write group must not be visible
+            if (gModel.count == 0)
+            {
+                FUZZ_CHECK(Rb_GetUnreadIndexCount(gModel.bufferHandle) == 0);
+            }
+            break;
+
+        case Fuzz_Op_GROUP_BEGIN:
+            if (gModel.groupOpenF == c_TRUE)
+            {
+                break;
+            }
+
+            FUZZ_CHECK(Rb_BeginWriteGroup(gModel.bufferHandle) == c_TRUE);
+            gModel.groupOpenF = c_TRUE;
+            break;
+
+        case Fuzz_Op_GROUP_END:
+            if (gModel.groupOpenF == c_FALSE)
+            {
+                break;
+            }
+
+            if (arg[0] & 1)
+            {
+                FUZZ_CHECK(Rb_PublishWriteGroup(gModel.bufferHandle) == c_TRUE);
+                gModel.count += gModel.groupCount;
+            }
+            else
+            {
+                FUZZ_CHECK(Rb_AbortWriteGroup(gModel.bufferHandle) == c_TRUE);
+            }
+
+            gModel.groupOpenF = c_FALSE;
+            gModel.groupCount = 0;
+            break;
+
+        case Fuzz_Op_TAG_FILTER:
+            gModel.tagFilter = (arg[0] & 0x0f) ? (cU64_t)(arg[0] & 0x0f) : ~0ULL;
+            FUZZ_CHECK(Rb_SetTagFilter(gModel.bufferHandle, gModel.tagFilter) == c_TRUE);
+            break;
+
+        default:
+            break;
+    }
+}
+
+#ifdef RB_FUZZ_REPLAY
+//----------------------------------------------------------------------------
+/**
+ * @brief Replay a corpus through the fuzz target, once or repeatedly to measure operations per second.
+ * @param argc Number of arguments.
+ * @param argv [-b] followed by corpus files or directories, the built-in corpus is used if none are given.
+ * @return int Returns 0 on success, 1 if a corpus file could not be read. Failed checks abort.
+ */
+int main(int argc, char *argv[])
+{
+    cBool  benchF = c_FALSE;
+    cU32_t roundId, rounds = 1;
+    cU64_t inputCnt = 0, pathInputCnt, startNs, elapsedNs;
+    int    argId = 1, pathId;
+
+    if ((argc > 1) && (strcmp(argv[1], "-b") == 0))
+    {
+        benchF = c_TRUE;
+        rounds = BENCH_ROUNDS;
+        argId = 2;
+    }
+
+    if (benchF == c_TRUE)
+    {
+        // Error prints of rejected writes would be part of the measurement
+        if (freopen("/dev/null", "w", stderr) == NULL)
+        {
+            return 1;
+        }
+    }
+
+    startNs = Rb_GetTimeNs();
+    for (roundId = 0; roundId < rounds; roundId++)
+    {
+        if (argId == argc)
+        {
+            replayGenerated();
+            inputCnt += GEN_INPUT_CNT;
+            continue;
+        }
+
+        for (pathId = argId; pathId < argc; pathId++)
+        {
+            pathInputCnt = replayPath(argv[pathId]);
+            if (pathInputCnt == 0)
+            {
+                printf("failed to read corpus: %s\n", argv[pathId]);
+                return 1;
+            }
+            inputCnt += pathInputCnt;
+        }
+    }
+    elapsedNs = Rb_GetTimeNs() - startNs;
+
+    printf("replayed %lu inputs, %lu operations", inputCnt, gOpCnt);
+    if (benchF == c_TRUE)
+    {
+        printf(", %.0f ops/s, %.0f inputs/s", (double)gOpCnt * 1e9 / (double)elapsedNs,
+               (double)inputCnt * 1e9 / (double)elapsedNs);
+    }
+    printf("\n");
+
+    Rb_DeinitModule();
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Read a whole file into memory.
+ * @param path Path of the file.
+ * @param data Pointer to store the allocated file contents, freed by the caller.
+ * @param size Pointer to store the size of the file in bytes.
+ * @return cBool Returns c_TRUE if the file is read successfully, otherwise c_FALSE
+ */
+static cBool loadFile(const char *path, cU8_t **data, cSize_t *size)
+{
+    FILE  *file = fopen(path, "rb");
+    long   fileBytes;
+
+    if (file == NULL)
+    {
+        return c_FALSE;
+    }
+
+    fseek(file, 0, SEEK_END);
+    fileBytes = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    *data = (cU8_t *)malloc((fileBytes > 0) ? (cSize_t)fileBytes : 1);
+    if ((fileBytes < 0) || (*data == NULL) || (fread(*data, 1, (cSize_t)fileBytes, file) != (cSize_t)fileBytes))
+    {
+        free(*data);
+        fclose(file);
+        return c_FALSE;
+    }
+
+    *size = (cSize_t)fileBytes;
+    fclose(file);
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Replay a corpus file, or every file of a corpus directory.
+ * @param path Path of the file or directory.
+ * @return cU64_t Returns the number of inputs replayed, 0 on failure.
+ */
+static cU64_t replayPath(const char *path)
+{
+    struct dirent *entry;
+    struct stat    pathStat;
+    DIR           *dir;
+    char           filePath[4096];
+    cU8_t         *data;
+    cSize_t        size;
+    cU64_t         inputCnt = 0;
+
+    if (stat(path, &pathStat) != 0)
+    {
+        return 0;
+    }
+
+    if (S_ISDIR(pathStat.st_mode) == 0)
+    {
+        if (loadFile(path, &data, &size) == c_FALSE)
+        {
+            return 0;
+        }
+
+        LLVMFuzzerTestOneInput(data, size);
+        free(data);
+        return 1;
+    }
+
+    dir = opendir(path);
+    if (dir == NULL)
+    {
+        return 0;
+    }
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        snprintf(filePath, sizeof(filePath), "%s/%s", path, entry->d_name);
+        if ((stat(filePath, &pathStat) == 0) && (S_ISREG(pathStat.st_mode) != 0) &&
+            (loadFile(filePath, &data, &size) == c_TRUE))
+        {
+            LLVMFuzzerTestOneInput(data, size);
+            free(data);
+            inputCnt++;
+        }
+    }
+
+    closedir(dir);
+    return inputCnt;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Replay the built-in corpus, pseudo random inputs from a fixed seed so runs are comparable.
+ */
+static void replayGenerated(void)
+{
+    static cU8_t input[GEN_INPUT_CNT][GEN_INPUT_BYTES];
+    static cBool generatedF = c_FALSE;
+    cU64_t       state = 0x9e3779b97f4a7c15ULL;
+    cU32_t       inputId, byteId;
+
+    // Generate once, so benchmark rounds measure only the target
+    for (inputId = 0; (generatedF == c_FALSE) && (inputId < GEN_INPUT_CNT); inputId++)
+    {
+        for (byteId = 0; byteId < GEN_INPUT_BYTES; byteId++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            input[inputId][byteId] = (cU8_t)state;
+        }
+    }
+    generatedF = c_TRUE;
+
+    for (inputId = 0; inputId < GEN_INPUT_CNT; inputId++)
+    {
+        LLVMFuzzerTestOneInput(input[inputId], GEN_INPUT_BYTES);
+    }
+}
+#endif
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
@@ -0,0 +1,273 @@
+/*****************************************************************************
+ * @file    common_crc32c.c
+ * @author  Kshitij Mistry
+ * @brief   Implementation of CRC32C checksum
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "common_crc32c.h"
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** CRC32C polynomial in reflected bit order */
+#define CRC32C_POLY       (0x82F63B78U)
+
+/** Bytes processed by each of the three interleaved hardware lanes per step */
+#define CRC32C_LANE_BYTES (256)
+
+/*****************************************************************************
+ * VARIABLES
+ *****************************************************************************/
+static cU32_t gCrc32cTable[8][256];            /**< Slicing-by-8 lookup tables */
+
+static cU32_t gCrc32cShift1Table[4][256];      /**< Tables to shift a crc over one lane of zero bytes */
+
+static cU32_t gCrc32cShift2Table[4][256];      /**< Tables to shift a crc over two lanes of zero bytes */
+
+static cBool  gCrc32cHwF = c_FALSE;            /**< Flag to indicate if the crc32 instruction is available */
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+static cU32_t multModP(cU32_t a, cU32_t b);
+
+static cU32_t xPow8nModP(cU64_t n);
+
+static cU32_t crc32cSw(cU32_t crc, const cU8_t *data, cSize_t dataBytes);
+
+#if defined(__x86_64__)
+static cU32_t crc32cHw(cU32_t crc, const cU8_t *data, cSize_t dataBytes);
+#endif
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Build lookup tables and detect hardware support, must be called before computing checksums.
+ */
+void Crc32c_Init(void)
+{
+    cU32_t byteVal, bitId, sliceId, crc, shift1, shift2;
+
+    for (byteVal = 0; byteVal < 256; byteVal++)
+    {
+        crc = byteVal;
+        for (bitId = 0; bitId < 8; bitId++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ CRC32C_POLY) : (crc >> 1);
+        }
+
+        gCrc32cTable[0][byteVal] = crc;
+    }
+
+    for (byteVal = 0; byteVal < 256; byteVal++)
+    {
+        for (sliceId = 1; sliceId < 8; sliceId++)
+        {
+            crc = gCrc32cTable[sliceId - 1][byteVal];
+            gCrc32cTable[sliceId][byteVal] = (crc >> 8) ^ gCrc32cTable[0][crc & 0xFF];
+        }
+    }
+
+    // Shifting a crc over zero bytes is a multiplication by a constant, split per input byte
+    shift1 = xPow8nModP(CRC32C_LANE_BYTES);
+    shift2 = xPow8nModP(2 * CRC32C_LANE_BYTES);
+    for (sliceId = 0; sliceId < 4; sliceId++)
+    {
+        for (byteVal = 0; byteVal < 256; byteVal++)
+        {
+            gCrc32cShift1Table[sliceId][byteVal] = multModP(shift1, byteVal << (8 * sliceId));
+            gCrc32cShift2Table[sliceId][byteVal] = multModP(shift2, byteVal << (8 * sliceId));
+        }
+    }
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    gCrc32cHwF = __builtin_cpu_supports("sse4.2") ? c_TRUE : c_FALSE;
+#endif
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Extend a crc32c value with more data.
+ * @param crc CRC32C of the preceding data, 0 for the first call.
+ * @param data Pointer to the data.
+ * @param dataBytes Size of the data in bytes.
+ * @return cU32_t Returns the CRC32C of the preceding data followed by this data.
+ */
+cU32_t Crc32c_Extend(cU32_t crc, const cU8_t *data, cSize_t dataBytes)
+{
+#if defined(__x86_64__)
+    if (gCrc32cHwF == c_TRUE)
+    {
+        return ~crc32cHw(~crc, data, dataBytes);
+    }
+#endif
+
+    return ~crc32cSw(~crc, data, dataBytes);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Compute the crc32c of the data.
+ * @param data Pointer to the data.
+ * @param dataBytes Size of the data in bytes.
+ * @return cU32_t Returns the CRC32C of the data.
+ */
+cU32_t Crc32c_Compute(const cU8_t *data, cSize_t dataBytes)
+{
+    return Crc32c_Extend(0, data, dataBytes);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Multiply two polynomials modulo the crc32c polynomial (reflected bit order).
+ * @param a First polynomial.
+ * @param b Second polynomial.
+ * @return cU32_t Returns the product modulo the polynomial.
+ */
+static cU32_t multModP(cU32_t a, cU32_t b)
+{
+    cU32_t mask = 1U << 31, product = 0;
+
+    while (mask != 0)
+    {
+        if (a & mask)
+        {
+            product ^= b;
+        }
+
+        mask >>= 1;
+        b = (b & 1) ? ((b >> 1) ^ CRC32C_POLY) : (b >> 1);
+    }
+
+    return product;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Compute x^(8n) modulo the crc32c polynomial, the operator that shifts a crc over n zero bytes.
+ * @param n Number of bytes.
+ * @return cU32_t Returns the shift operator.
+ */
+static cU32_t xPow8nModP(cU64_t n)
+{
+    cU32_t result = 1U << 31;  // x^0
+    cU32_t square = 1U << 23;  // x^8
+
+    while (n != 0)
+    {
+        if (n & 1)
+        {
+            result = multModP(square, result);
+        }
+
+        square = multModP(square, square);
+        n >>= 1;
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Portable slicing-by-8 crc32c on the raw (non-inverted) register value.
+ * @param crc Current crc register.
+ * @param data Pointer to the data.
+ * @param dataBytes Size of the data in bytes.
+ * @return cU32_t Returns the updated crc register.
+ */
+static cU32_t crc32cSw(cU32_t crc, const cU8_t *data, cSize_t dataBytes)
+{
+    cU64_t word;
+
+    while (dataBytes >= 8)
+    {
+        memcpy(&word, data, sizeof(word));
+        word ^= crc;
+        crc = gCrc32cTable[7][word & 0xFF] ^ gCrc32cTable[6][(word >> 8) & 0xFF] ^ gCrc32cTable[5][(word >> 16) & 0xFF] ^
+              gCrc32cTable[4][(word >> 24) & 0xFF] ^ gCrc32cTable[3][(word >> 32) & 0xFF] ^
+              gCrc32cTable[2][(word >> 40) & 0xFF] ^ gCrc32cTable[1][(word >> 48) & 0xFF] ^ gCrc32cTable[0][word >> 56];
+        data += 8;
+        dataBytes -= 8;
+    }
+
+    while (dataBytes > 0)
+    {
+        crc = (crc >> 8) ^ gCrc32cTable[0][(crc ^ *data) & 0xFF];
+        data++;
+        dataBytes--;
+    }
+
+    return crc;
+}
+
+#if defined(__x86_64__)
+//----------------------------------------------------------------------------
+/**
+ * @brief SSE4.2 crc32c on the raw (non-inverted) register value.
+ * @param crc Current crc register.
+ * @param data Pointer to the data.
+ * @param dataBytes Size of the data in bytes.
+ * @return cU32_t Returns the updated crc register.
+ * @note  The crc32 instruction has a latency of three cycles but a throughput of one per cycle, so large
+ *        inputs are split in three lanes computed in parallel and merged with the shift tables.
+ */
+__attribute__((target("sse4.2"))) static cU32_t crc32cHw(cU32_t crc, const cU8_t *data, cSize_t dataBytes)
+{
+    cU64_t crc0 = crc, crc1, crc2, word0, word1, word2;
+    cSize_t byteId;
+
+    while (dataBytes >= (3 * CRC32C_LANE_BYTES))
+    {
+        crc1 = 0;
+        crc2 = 0;
+        for (byteId = 0; byteId < CRC32C_LANE_BYTES; byteId += 8)
+        {
+            memcpy(&word0, data + byteId, sizeof(word0));
+            memcpy(&word1, data + CRC32C_LANE_BYTES + byteId, sizeof(word1));
+            memcpy(&word2, data + (2 * CRC32C_LANE_BYTES) + byteId, sizeof(word2));
+            crc0 = _mm_crc32_u64(crc0, word0);
+            crc1 = _mm_crc32_u64(crc1, word1);
+            crc2 = _mm_crc32_u64(crc2, word2);
+        }
+
+        crc0 = gCrc32cShift2Table[0][crc0 & 0xFF] ^ gCrc32cShift2Table[1][(crc0 >> 8) & 0xFF] ^
+               gCrc32cShift2Table[2][(crc0 >> 16) & 0xFF] ^ gCrc32cShift2Table[3][(crc0 >> 24) & 0xFF] ^
+               gCrc32cShift1Table[0][crc1 & 0xFF] ^ gCrc32cShift1Table[1][(crc1 >> 8) & 0xFF] ^
+               gCrc32cShift1Table[2][(crc1 >> 16) & 0xFF] ^ gCrc32cShift1Table[3][(crc1 >> 24) & 0xFF] ^ crc2;
+        data += (3 * CRC32C_LANE_BYTES);
+        dataBytes -= (3 * CRC32C_LANE_BYTES);
+    }
+
+    while (dataBytes >= 8)
+    {
+        memcpy(&word0, data, sizeof(word0));
+        crc0 = _mm_crc32_u64(crc0, word0);
+        data += 8;
+        dataBytes -= 8;
+    }
+
+    while (dataBytes > 0)
+    {
+        crc0 = _mm_crc32_u8((cU32_t)crc0, *data);
+        data++;
+        dataBytes--;
+    }
+
+    return (cU32_t)crc0;
+}
+#endif
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
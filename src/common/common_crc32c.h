@@ -0,0 +1,28 @@
+/*****************************************************************************
+ * @file    common_crc32c.h
+ * @author  Kshitij Mistry
+ * @brief   CRC32C (Castagnoli) checksum with hardware acceleration.
+ *
+ * Uses the SSE4.2 crc32 instruction over three interleaved lanes when the CPU supports it and falls
+ * back to a portable slicing-by-8 implementation otherwise.
+ *
+ *****************************************************************************/
+#pragma once
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "common_stddef.h"
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+void Crc32c_Init(void);
+
+cU32_t Crc32c_Extend(cU32_t crc, const cU8_t *data, cSize_t dataBytes);
+
+cU32_t Crc32c_Compute(const cU8_t *data, cSize_t dataBytes);
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
@@ -0,0 +1,379 @@
+/*****************************************************************************
+ * @file    common_lz.c
+ * @author  Kshitij Mistry
+ * @brief   Implementation of LZ77 block codec
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "common_lz.h"
+#include <string.h>
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** Minimum length of a match */
+#define LZ_MIN_MATCH      (4)
+
+/** Maximum distance of a match */
+#define LZ_MAX_OFFSET     (65535)
+
+/** Bytes at the end of the input that are always literals */
+#define LZ_LAST_LITERALS  (5)
+
+/** No match may start in the last bytes of the input */
+#define LZ_MATCH_LIMIT    (12)
+
+/** Maximum and minimum number of bits of the match finder hash */
+#define LZ_MAX_HASH_BITS  (12)
+#define LZ_MIN_HASH_BITS  (8)
+
+/** Number of misses after which the match finder starts skipping bytes */
+#define LZ_SKIP_TRIGGER   (6)
+
+/** Length value stored in a token nibble when extension bytes follow */
+#define LZ_RUN_MASK       (15)
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+static cU32_t read32(const cU8_t *src);
+
+static cU32_t hash32(cU32_t seq, cU32_t hashBits);
+
+static cU8_t *writeLength(cU8_t *dst, cU8_t *dstEnd, cSize_t length);
+
+static cU8_t *writeSequence(cU8_t *dst, cU8_t *dstEnd, const cU8_t *literals, cSize_t literalBytes, cU32_t offset,
+                            cSize_t matchBytes);
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Compress a block.
+ * @param src Pointer to the input data.
+ * @param srcBytes Size of the input data in bytes.
+ * @param dst Pointer to the output buffer.
+ * @param dstCapacity Size of the output buffer in bytes.
+ * @return cSize_t Returns the compressed size, or 0 if the output does not fit in dstCapacity.
+ * @note  Passing a capacity smaller than srcBytes makes the compressor give up as soon as the data proves
+ *        not to be compressible enough, which keeps incompressible input cheap.
+ */
+cSize_t Lz_Compress(const cU8_t *src, cSize_t srcBytes, cU8_t *dst, cSize_t dstCapacity)
+{
+    cU32_t       hashTable[1 << LZ_MAX_HASH_BITS];
+    cU32_t       hashBits = LZ_MIN_HASH_BITS;
+    const cU8_t *pInput = src;
+    const cU8_t *pAnchor = src;
+    const cU8_t *pInputEnd = src + srcBytes;
+    const cU8_t *pMatchLimit = pInputEnd - LZ_LAST_LITERALS;
+    cU8_t       *pOutput = dst;
+    cU8_t       *pOutputEnd = dst + dstCapacity;
+    cU32_t       missCnt = 0;
+
+    if ((src == NULL) || (dst == NULL))
+    {
+        return 0;
+    }
+
+    if (srcBytes > LZ_MATCH_LIMIT)
+    {
+        // Smaller inputs need a smaller table, clearing it dominates the cost of short records
+        while ((hashBits < LZ_MAX_HASH_BITS) && ((1ULL << hashBits) < (srcBytes / 2)))
+        {
+            hashBits++;
+        }
+
+        memset(hashTable, 0, sizeof(cU32_t) << hashBits);
+        pInput++;
+
+        while (pInput < (pInputEnd - LZ_MATCH_LIMIT))
+        {
+            cU32_t       seq = read32(pInput);
+            cU32_t       hashVal = hash32(seq, hashBits);
+            const cU8_t *pRef = src + hashTable[hashVal];
+            cSize_t      matchBytes;
+
+            hashTable[hashVal] = (cU32_t)(pInput - src);
+
+            if ((pRef >= pInput) || ((pInput - pRef) > LZ_MAX_OFFSET) || (read32(pRef) != seq))
+            {
+                pInput += 1 + (missCnt++ >> LZ_SKIP_TRIGGER);
+                continue;
+            }
+
+            // Extend the match backwards over pending literals
+            while ((pInput > pAnchor) && (pRef > src) && (pInput[-1] == pRef[-1]))
+            {
+                pInput--;
+                pRef--;
+            }
+
+            matchBytes = LZ_MIN_MATCH;
+            while (((pInput + matchBytes) < pMatchLimit) && (pRef[matchBytes] == pInput[matchBytes]))
+            {
+                matchBytes++;
+            }
+
+            pOutput = writeSequence(pOutput, pOutputEnd, pAnchor, (cSize_t)(pInput - pAnchor), (cU32_t)(pInput - pRef),
+                                    matchBytes);
+            if (pOutput == NULL)
+            {
+                return 0;
+            }
+
+            pInput += matchBytes;
+            pAnchor = pInput;
+            missCnt = 0;
+        }
+    }
+
+    // Last sequence only carries literals
+    pOutput = writeSequence(pOutput, pOutputEnd, pAnchor, (cSize_t)(pInputEnd - pAnchor), 0, 0);
+    if (pOutput == NULL)
+    {
+        return 0;
+    }
+
+    return (cSize_t)(pOutput - dst);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Decompress a block produced by Lz_Compress.
+ * @param src Pointer to the compressed data.
+ * @param srcBytes Size of the compressed data in bytes.
+ * @param dst Pointer to the output buffer.
+ * @param dstCapacity Size of the output buffer in bytes.
+ * @return cSize_t Returns the decompressed size, or 0 if the input is malformed or the output does not fit.
+ */
+cSize_t Lz_Decompress(const cU8_t *src, cSize_t srcBytes, cU8_t *dst, cSize_t dstCapacity)
+{
+    const cU8_t *pInput = src;
+    const cU8_t *pInputEnd = src + srcBytes;
+    cU8_t       *pOutput = dst;
+    cU8_t       *pOutputEnd = dst + dstCapacity;
+
+    if ((src == NULL) || (dst == NULL))
+    {
+        return 0;
+    }
+
+    while (pInput < pInputEnd)
+    {
+        cU8_t   token = *pInput++;
+        cSize_t literalBytes = token >> 4;
+        cSize_t matchBytes = token & LZ_RUN_MASK;
+        cSize_t offset, byteId;
+        cU8_t   extByte;
+
+        if (literalBytes == LZ_RUN_MASK)
+        {
+            do
+            {
+                if (pInput >= pInputEnd)
+                {
+                    return 0;
+                }
+
+                extByte = *pInput++;
+                literalBytes += extByte;
+            } while (extByte == 255);
+        }
+
+        if (((cSize_t)(pInputEnd - pInput) < literalBytes) || ((cSize_t)(pOutputEnd - pOutput) < literalBytes))
+        {
+            return 0;
+        }
+
+        memcpy(pOutput, pInput, literalBytes);
+        pInput += literalBytes;
+        pOutput += literalBytes;
+
+        if (pInput == pInputEnd)
+        {
+            // Last sequence has no match
+            break;
+        }
+
+        if ((pInputEnd - pInput) < 2)
+        {
+            return 0;
+        }
+
+        offset = (cSize_t)pInput[0] | ((cSize_t)pInput[1] << 8);
+        pInput += 2;
+
+        if (matchBytes == LZ_RUN_MASK)
+        {
+            do
+            {
+                if (pInput >= pInputEnd)
+                {
+                    return 0;
+                }
+
+                extByte = *pInput++;
+                matchBytes += extByte;
+            } while (extByte == 255);
+        }
+
+        matchBytes += LZ_MIN_MATCH;
+
+        if ((offset == 0) || (offset > (cSize_t)(pOutput - dst)) || ((cSize_t)(pOutputEnd - pOutput) < matchBytes))
+        {
+            return 0;
+        }
+
+        if (offset >= matchBytes)
+        {
+            memcpy(pOutput, pOutput - offset, matchBytes);
+            pOutput += matchBytes;
+        }
+        else
+        {
+            // Overlapping match repeats the last offset bytes
+            for (byteId = 0; byteId < matchBytes; byteId++)
+            {
+                pOutput[0] = pOutput[-(cLong_t)offset];
+                pOutput++;
+            }
+        }
+    }
+
+    return (cSize_t)(pOutput - dst);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Read 4 bytes from an unaligned address.
+ * @param src Pointer to the data.
+ * @return cU32_t Returns the 4 bytes as an integer.
+ */
+static cU32_t read32(const cU8_t *src)
+{
+    cU32_t value;
+
+    memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Hash 4 bytes for the match finder table.
+ * @param seq 4 bytes to hash.
+ * @param hashBits Number of bits of the hash.
+ * @return cU32_t Returns the hash value.
+ */
+static cU32_t hash32(cU32_t seq, cU32_t hashBits)
+{
+    return ((seq * 2654435761U) >> (32 - hashBits));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Write the extension bytes of a length that does not fit in a token nibble.
+ * @param dst Output position.
+ * @param dstEnd End of the output buffer.
+ * @param length Remaining length after the nibble value.
+ * @return cU8_t* Returns the new output position, or NULL if the output buffer is full.
+ */
+static cU8_t *writeLength(cU8_t *dst, cU8_t *dstEnd, cSize_t length)
+{
+    while (length >= 255)
+    {
+        if (dst >= dstEnd)
+        {
+            return NULL;
+        }
+
+        *dst++ = 255;
+        length -= 255;
+    }
+
+    if (dst >= dstEnd)
+    {
+        return NULL;
+    }
+
+    *dst++ = (cU8_t)length;
+    return dst;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Write one sequence of literals followed by a match.
+ * @param dst Output position.
+ * @param dstEnd End of the output buffer.
+ * @param literals Pointer to the literals.
+ * @param literalBytes Number of literals.
+ * @param offset Distance of the match, 0 for the last sequence which has no match.
+ * @param matchBytes Length of the match.
+ * @return cU8_t* Returns the new output position, or NULL if the output buffer is full.
+ */
+static cU8_t *writeSequence(cU8_t *dst, cU8_t *dstEnd, const cU8_t *literals, cSize_t literalBytes, cU32_t offset,
+                            cSize_t matchBytes)
+{
+    cU8_t *pToken = dst;
+
+    if (dst >= dstEnd)
+    {
+        return NULL;
+    }
+
+    dst++;
+
+    if (literalBytes >= LZ_RUN_MASK)
+    {
+        *pToken = (LZ_RUN_MASK << 4);
+        dst = writeLength(dst, dstEnd, literalBytes - LZ_RUN_MASK);
+        if (dst == NULL)
+        {
+            return NULL;
+        }
+    }
+    else
+    {
+        *pToken = (cU8_t)(literalBytes << 4);
+    }
+
+    if ((cSize_t)(dstEnd - dst) < literalBytes)
+    {
+        return NULL;
+    }
+
+    memcpy(dst, literals, literalBytes);
+    dst += literalBytes;
+
+    if (offset == 0)
+    {
+        return dst;
+    }
+
+    if ((dstEnd - dst) < 2)
+    {
+        return NULL;
+    }
+
+    *dst++ = (cU8_t)(offset & 0xFF);
+    *dst++ = (cU8_t)(offset >> 8);
+
+    matchBytes -= LZ_MIN_MATCH;
+    if (matchBytes >= LZ_RUN_MASK)
+    {
+        *pToken |= LZ_RUN_MASK;
+        dst = writeLength(dst, dstEnd, matchBytes - LZ_RUN_MASK);
+    }
+    else
+    {
+        *pToken |= (cU8_t)matchBytes;
+    }
+
+    return dst;
+}
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
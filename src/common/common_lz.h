@@ -0,0 +1,33 @@
+/*****************************************************************************
+ * @file    common_lz.h
+ * @author  Kshitij Mistry
+ * @brief   Fast LZ77 block codec.
+ *
+ * Byte-oriented LZ77 compressor and decompressor using the LZ4 block layout: each sequence is a token
+ * byte holding the literal and match lengths, the literals, a 16-bit little-endian match offset and
+ * length extension bytes. It trades ratio for speed and needs no external dependency.
+ *
+ *****************************************************************************/
+#pragma once
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "common_stddef.h"
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** Worst case compressed size of the input */
+#define LZ_COMPRESS_BOUND(srcBytes) ((srcBytes) + ((srcBytes) / 255) + 16)
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+cSize_t Lz_Compress(const cU8_t *src, cSize_t srcBytes, cU8_t *dst, cSize_t dstCapacity);
+
+cSize_t Lz_Decompress(const cU8_t *src, cSize_t srcBytes, cU8_t *dst, cSize_t dstCapacity);
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
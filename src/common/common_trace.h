@@ -0,0 +1,48 @@
+/*****************************************************************************
+ * @file    common_trace.h
+ * @author  Kshitij Mistry
+ * @brief   Static tracepoints (USDT probes) used across the project.
+ *
+ * Probes are compiled in only when RB_ENABLE_USDT is defined (cmake -DRB_ENABLE_USDT=ON), which requires
+ * <sys/sdt.h> from systemtap. Each enabled probe is a single NOP in the code plus an ELF note, so tools
+ * like bpftrace and perf can attach to it at run time. Without RB_ENABLE_USDT probes and their arguments
+ * are compiled out completely.
+ *
+ *****************************************************************************/
+#pragma once
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#ifdef RB_ENABLE_USDT
+#include <sys/sdt.h>
+#endif
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+#ifdef RB_ENABLE_USDT
+
+// Fire a probe with two arguments
+#define TRACE_PROBE2(provider, name, arg1, arg2)       DTRACE_PROBE2(provider, name, arg1, arg2)
+
+// Fire a probe with three arguments
+#define TRACE_PROBE3(provider, name, arg1, arg2, arg3) DTRACE_PROBE3(provider, name, arg1, arg2, arg3)
+
+#else
+
+#define TRACE_PROBE2(provider, name, arg1, arg2) \
+    do                                           \
+    {                                            \
+    } while (0)
+
+#define TRACE_PROBE3(provider, name, arg1, arg2, arg3) \
+    do                                                 \
+    {                                                  \
+    } while (0)
+
+#endif
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
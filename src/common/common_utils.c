@@ -0,0 +1,48 @@
+/*****************************************************************************
+ * @file    common_utils.c
+ * @author  Kshitij Mistry
+ * @brief   Implementation of time utilities
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "common_utils.h"
+#include <time.h>
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the monotonic clock time.
+ * @return cU64_t Returns the time in nanoseconds since an unspecified starting point.
+ */
+cU64_t Utils_GetMonotonicTimeNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((cU64_t)ts.tv_sec * NANO_SECONDS_PER_SECOND) + (cU64_t)ts.tv_nsec;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the coarse monotonic clock time, read from the vDSO without a system call.
+ * @return cU64_t Returns the time in nanoseconds since an unspecified starting point, updated once per tick.
+ */
+cU64_t Utils_GetCoarseTimeNs(void)
+{
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return ((cU64_t)ts.tv_sec * NANO_SECONDS_PER_SECOND) + (cU64_t)ts.tv_nsec;
+}
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
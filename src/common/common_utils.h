@@ -0,0 +1,28 @@
+/*****************************************************************************
+ * @file    common_utils.h
+ * @author  Kshitij Mistry
+ * @brief   Time utilities used across the project.
+ *****************************************************************************/
+#pragma once
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include "common_stddef.h"
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+// Nanosecond per second
+#define NANO_SECONDS_PER_SECOND (1000000000LL)
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+cU64_t Utils_GetMonotonicTimeNs(void);
+
+cU64_t Utils_GetCoarseTimeNs(void);
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
@@ -7,7 +7,6 @@
  *          - Add support for multiple readers/writers with proper synchronization.
  *          - Add support for partial read within a data chunk.
  *          - Make MAX_BUFFER_HANDLE and MAX_ALLOWED_BUFFER_SIZE_IN_BYTES configurable.
- *          - Add apis to copy data from ring buffer to user provided buffer.
  *****************************************************************************/
 
 /*****************************************************************************
@@ -17,6 +16,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include "common_def.h"
+#include "common_crc32c.h"
+#include "common_lz.h"
+#include "common_trace.h"
+#include "common_utils.h"
 
 /*****************************************************************************
  * MACROS
@@ -32,62 +35,346 @@
 /** Maximum number of buffer handles supported */
 #define MAX_BUFFER_HANDLE                (10)
 
-/** Check if buffer handle is valid */
-#define IS_VALID_BUFFER_HANDLE(handle) \
-    (((handle) >= 0) && ((handle) < MAX_BUFFER_HANDLE) && (gRbInfo[(handle)].bufferHandle != INVALID_BUFFER_HANDLE))
+/** Maximum number of module contexts, including the default context */
+#define MAX_CONTEXTS                     (16)
 
-/** Check if reading fragmented data */
-#define IS_DATA_FRAGMENTED(rbInfo) \
-        (((rbInfo->pReader + rbInfo->dataLen[rbInfo->readIndex]) == (rbInfo->pBufferBegin + rbInfo->size)) && ((rbInfo)->fragmentedDataF == c_TRUE))
+/** Bits of a buffer handle holding the slot within its context, the bits above hold the context */
+#define CONTEXT_HANDLE_SHIFT             (8)
 
-/** Macro to check if buffer is empty (all data has been read) */
-#define IS_BUFFER_EMPTY(bufferHandle) (getFreeSpace(bufferHandle) == gRbInfo[(bufferHandle)].size)
+/** Build the buffer handle of a slot in a context, handles of the default context are the slot numbers */
+#define MAKE_BUFFER_HANDLE(contextId, slotId) (((contextId) << CONTEXT_HANDLE_SHIFT) | (slotId))
+
+/** Get the context of a buffer handle */
+#define GET_CONTEXT_ID(handle)           ((handle) >> CONTEXT_HANDLE_SHIFT)
+
+/** Get the slot of a buffer handle within its context */
+#define GET_SLOT_ID(handle)              ((handle) & ((1 << CONTEXT_HANDLE_SHIFT) - 1))
+
+/** Context of a handle, loaded with acquire so a context published by another thread is seen initialized */
+#define GET_CONTEXT(handle)              __atomic_load_n(&gRbContext[GET_CONTEXT_ID(handle)], __ATOMIC_ACQUIRE)
+
+/** Ring buffer information of a handle, the handle must be in range */
+#define RB_INFO(handle)                  (GET_CONTEXT(handle)->rbInfo[GET_SLOT_ID(handle)])
+
+/** Check if buffer handle is valid, hidden lanes of other buffers are not valid handles */
+#define IS_VALID_BUFFER_HANDLE(handle)                                                                  \
+    (((handle) >= 0) && (GET_CONTEXT_ID(handle) < MAX_CONTEXTS) && (GET_SLOT_ID(handle) < MAX_BUFFER_HANDLE) && \
+     (GET_CONTEXT(handle) != NULL) && (RB_INFO(handle).bufferHandle != INVALID_BUFFER_HANDLE) && \
+     (RB_INFO(handle).ownerHandle == (handle)))
+
+/** Check if a resolved handle still refers to the buffer it was acquired for */
+#define IS_VALID_REF(ref) \
+    (((ref) != NULL) && ((ref)->info != NULL) && (((Rb_Info_t *)(ref)->info)->generation == (ref)->generation))
+
+/** Check if the record at the read index is split across the end of the buffer */
+#define IS_DATA_FRAGMENTED(rbInfo) (((rbInfo)->entry[(rbInfo)->readIndex].flags & RECORD_FLAG_FRAGMENTED) != 0)
+
+/** Check if the record at the read index is stored compressed */
+#define IS_DATA_COMPRESSED(rbInfo) (((rbInfo)->entry[(rbInfo)->readIndex].flags & RECORD_FLAG_COMPRESSED) != 0)
+
+/** Check if there is no published unread data index */
+#define IS_NO_DATA_TO_READ(rbInfo) ((rbInfo)->readIndex == (rbInfo)->pubWriteIndex)
+
+/** Position in the buffer memory of a byte offset, offsets only grow and are reduced only to dereference them */
+#define RING_POS(rbInfo, offset) ((offset) % (rbInfo)->size)
+
+/** Pointer into the buffer memory of a byte offset */
+#define RING_PTR(rbInfo, offset) ((rbInfo)->pBufferBegin + RING_POS(rbInfo, offset))
+
+/** Consumer offset moved up to the last compaction, the tail the writer skipped before it holds no data */
+#define PAST_COMPACTION(rbInfo, offset) (((offset) > (rbInfo)->compactOffset) ? (offset) : (rbInfo)->compactOffset)
+
+/** Macro to check if buffer is empty (all data has been read and nothing is retained) */
+#define IS_BUFFER_EMPTY(rbInfo) (PAST_COMPACTION(rbInfo, (rbInfo)->retainOffset) == (rbInfo)->writeOffset)
 
 /** Maximum number of data indices in the ring buffer */
 #define MAX_DATA_INDEX (1000LL)
 
+/** Number of bits in one ready-map word */
+#define READY_MAP_WORD_BITS (64)
+
+/** Number of 64-bit words needed to hold one ready bit per buffer handle */
+#define READY_MAP_WORDS ((MAX_BUFFER_HANDLE + READY_MAP_WORD_BITS - 1) / READY_MAP_WORD_BITS)
+
+/** Default scheduling weight of a buffer */
+#define DEFAULT_SCHED_WEIGHT (1)
+
+/** Records smaller than this are always stored raw */
+#define MIN_COMPRESS_BYTES (64)
+
+/** Compressed record is kept only if it saves at least 1/MIN_COMPRESS_SAVING of the raw size */
+#define MIN_COMPRESS_SAVING (8)
+
+/** Record flag: record is stored compressed */
+#define RECORD_FLAG_COMPRESSED (0x01)
+
+/** Record flag: record is split across the end of the buffer over two indices */
+#define RECORD_FLAG_FRAGMENTED (0x02)
+
+/** Number of record tags, one bit each in a tag filter */
+#define TAG_CNT (64)
+
+/** Bit of a tag in the record index and in tag filters */
+#define TAG_BIT(tag) (1ULL << (tag))
+
+/** Tag filter serving all records */
+#define ALL_TAGS (~0ULL)
+
+/** Largest burst of a rate limit, keeps the refill arithmetic of a token bucket within 64 bits */
+#define MAX_RATE_BURST (1ULL << 32)
+
+/** Alignment of the scratch memory */
+#define SCRATCH_ALIGNMENT (16)
+
+/** Maximum number of priority lanes of a buffer */
+#define MAX_LANES (4)
+
+/** Maximum number of records the reader prefetches ahead */
+#define MAX_PREFETCH_DEPTH (16)
+
+/** Size of a cache line in bytes */
+#define CACHE_LINE_BYTES (64)
+
+/** Default number of written records after which the write cursor is published */
+#define DEFAULT_PUBLISH_RECORDS (1)
+
+/** Default number of consumed records after which their space is released to the writer */
+#define DEFAULT_RELEASE_RECORDS (1)
+
 /*****************************************************************************
  * STRUCTURES
  *****************************************************************************/
 typedef struct
+{
+    cU64_t seq;                     /**< Sequence number of the record */
+    cU64_t timeStamp;               /**< Write time of the record in nanoseconds, 0 unless stamped */
+    cU32_t dataLen;                 /**< Length of the data at the index, buffers are far below 4 GB */
+    cU32_t dataOffset;              /**< Offset of the data at the index from the buffer beginning */
+    cU32_t crc;                     /**< Checksum of the record, only set with integrity checking */
+    cU32_t userWord;                /**< User word of the record, 0 unless written with Rb_WriteTaggedToLane */
+    cU32_t rawLen;                  /**< Length of the whole record before encoding, as returned to the reader */
+    cU8_t  flags;                   /**< Flags of the record */
+    cU8_t  tag;                     /**< Tag of the record */
+
+} Rb_IndexEntry_t;
+
+typedef struct
+{
+    cI64_t tokens;                  /**< Available tokens, negative while a record larger than the balance is paid off */
+    cU64_t refillNs;                /**< Coarse time up to which tokens have been added */
+    cU64_t fillNs;                  /**< Time to refill an empty bucket up to its burst */
+
+} Rb_TokenBucket_t;
+
+typedef struct Rb_Info
 {
     cU8_t *pBufferBegin;            /**< Pointer to the buffer memory */
-    cU8_t *pWriter;                 /**< Pointer to the writer position in the buffer */
-    cU8_t *pReader;                 /**< Pointer to the reader position in the buffer */
+    cU64_t writeOffset;             /**< Bytes the writer has moved through the buffer, never rewound */
+    cU64_t readOffset;              /**< Bytes the reader has moved through the buffer, never rewound */
     cU64_t size;                    /**< Size of the buffer in bytes */
     cU64_t readIndex;               /**< Index for reading from the buffer */
     cU64_t writeIndex;              /**< Index for writing to the buffer */
-    cU64_t dataLen[MAX_DATA_INDEX]; /**< Length of data at each index */
+    Rb_IndexEntry_t entry[MAX_DATA_INDEX]; /**< Record index, everything a write or peek needs in one entry */
+    cU64_t tagFilter;               /**< Tags served by peek read, records with other tags are skipped */
+    cU8_t  peekTag;                 /**< Tag of the record returned by the last peek read */
+    cU32_t peekUserWord;            /**< User word of the record returned by the last peek read */
     cI32_t bufferHandle;            /**< Handle for the buffer */
-    cBool  fragmentedDataF;         /**< Flag to indicate if the data is fragmented */
-    cU8_t *fragmentedDataPtr;       /**< Pointer to hold fragmented data */
+    cU8_t *fragmentedDataPtr;       /**< Reassembly memory for fragmented records, kept for reuse across peeks */
+    cU64_t fragmentedDataSize;      /**< Size of the reassembly memory in bytes */
+    cBool  fragmentedPeekF;         /**< Flag to indicate if the outstanding peek returned a reassembled or decoded record */
     cBool  readCommittedF;          /**< Flag to indicate if the read has been committed */
+    cU32_t schedWeight;             /**< Consecutive picks granted by weighted-fair scheduling */
+    Rb_IntegrityMode_e integrityMode; /**< When the per-record checksum is verified */
+    cU32_t peekCrc;                 /**< Checksum of the record returned by the last peek read */
+    Rb_Codec_e codec;               /**< Codec applied to records on write */
+    cU8_t *codecBuf;                /**< Scratch memory holding the encoded record during write */
+    cU64_t codecBufSize;            /**< Size of the codec scratch memory in bytes */
+    cBool  timeStampF;              /**< Flag to indicate if records are stamped on write */
+    cU64_t peekTimeStamp;           /**< Write time of the record returned by the last peek read */
+    cU32_t peekRawLen;              /**< Length before encoding of the record returned by the last peek read */
+    cU64_t ttlNs;                   /**< Age in nanoseconds after which unread records expire, 0 to disable */
+    cU64_t nextSeq;                 /**< Sequence number of the next record to write */
+    cU64_t oldestSeq;               /**< Sequence number of the oldest retained or unread record */
+    cU64_t peekSeq;                 /**< Sequence number of the record returned by the last peek read */
+    cU16_t seqIndex[MAX_DATA_INDEX]; /**< First index of each record, indexed by sequence number */
+    cU64_t retainOffset;            /**< Offset of the oldest retained consumed record, equals reader without retention */
+    cU64_t retainIndex;             /**< Index of the oldest retained consumed record */
+    cU64_t retainCount;             /**< Number of consumed records currently retained */
+    cU64_t retainRecords;           /**< Number of consumed records to retain for replay */
+    cU8_t *replayBuf;               /**< Memory holding a fragmented record returned by peek at sequence */
+    cU64_t replayBufSize;           /**< Size of the replay memory in bytes */
+    cU64_t pubWriteIndex;           /**< Write index published to the reader */
+    cU64_t pubWriteOffset;          /**< Write offset published to the reader */
+    cU64_t pubSeq;                  /**< Sequence number of the first unpublished record */
+    cU32_t publishRecords;          /**< Number of written records after which the write cursor is published */
+    cU64_t publishBytes;            /**< Number of written bytes after which the write cursor is published, 0 to ignore */
+    cU32_t pendingRecords;          /**< Number of written records not yet published */
+    cU64_t pendingBytes;            /**< Number of written bytes not yet published */
+    cBool  groupOpenF;              /**< Flag set while a write group is open, its records are not published */
+    cU64_t groupWriteIndex;         /**< Write index when the write group was opened */
+    cU64_t groupWriteOffset;        /**< Write offset when the write group was opened */
+    cU64_t groupSeq;                /**< Sequence number of the first record of the write group */
+    cU32_t groupPendingRecords;     /**< Unpublished records written before the write group was opened */
+    cU64_t groupPendingBytes;       /**< Unpublished bytes written before the write group was opened */
+    cU64_t groupFragmentedRecords;  /**< Fragmented record count when the write group was opened */
+    cU64_t groupPaddedRecords;      /**< Padded record count when the write group was opened */
+    cU64_t groupPaddingBytes;       /**< Padding byte count when the write group was opened */
+    cU32_t releaseRecords;          /**< Number of consumed records after which their space is released */
+    cU32_t releasePending;          /**< Number of consumed records not yet released to the writer */
+    cU32_t prefetchDepth;           /**< Number of records ahead of the reader that are prefetched, 0 to disable */
+    cU64_t highWatermark;           /**< Occupancy in bytes that raises backpressure, 0 to disable, set on every lane */
+    cU64_t lowWatermark;            /**< Occupancy in bytes that clears backpressure, this and the rest only on lane 0 */
+    cBool  aboveHighF;              /**< Flag set between crossing the high and falling to the low watermark */
+    Rb_WatermarkCb_t watermarkCb;   /**< Callback invoked on watermark crossings */
+    void  *watermarkUserData;       /**< User data passed to the watermark callback */
+    cI32_t ownerHandle;             /**< Handle of the buffer owning this slot, differs only for hidden lanes */
+    cU32_t laneCnt;                 /**< Number of priority lanes, 1 when the buffer has no extra lanes */
+    cI32_t laneHandle[MAX_LANES];   /**< Slot of each lane, lane 0 is the buffer itself */
+    Rb_LanePolicy_e lanePolicy;     /**< Policy used to pick the lane served by peek read */
+    cU32_t laneWeight[MAX_LANES];   /**< Picks per round of each lane with weighted scheduling */
+    cU32_t laneCredit[MAX_LANES];   /**< Remaining picks in the current round of each lane */
+    struct Rb_Info *peekLane;       /**< Lane serving the outstanding peek read, resolved so refs skip the lookup */
+    Rb_WrapPolicy_e wrapPolicy;     /**< Placement of records that do not fit before the end of the buffer */
+    cBool  compactOnEmptyF;         /**< Flag to start the next lap at the first write into an empty buffer */
+    cU64_t compactOffset;           /**< Lap start the writer last compacted to, only written by the writer */
+    cBool  rateLimitF;              /**< Flag to indicate if writes are rate limited */
+    Rb_RateLimit_t rateLimit;       /**< Rates and bursts of the write rate limit */
+    Rb_TokenBucket_t byteBucket;    /**< Token bucket of written bytes */
+    Rb_TokenBucket_t recordBucket;  /**< Token bucket of written records */
+    cStatus_e writeStatus;          /**< Result of the last write to the buffer or lane, cStatus_SUCCESS if accepted */
+    Rb_Stats_t stats;               /**< Cumulative statistics of the buffer */
+    Rb_Allocator_t allocator;       /**< Allocator of the buffer memory and scratch memory */
+    cU32_t generation;              /**< Renewed each time the slot is released or initialized, invalidates references */
 
 } Rb_Info_t;
 
+typedef struct
+{
+    Rb_SchedPolicy_e policy;        /**< Policy used to pick the next ready buffer */
+    cI32_t           lastSlotId;    /**< Slot returned by the previous pick */
+    cU32_t           credit;        /**< Remaining consecutive picks of the last handle */
+
+} Rb_SchedInfo_t;
+
+struct Rb_Context
+{
+    cI32_t         contextId;                   /**< Index of the context in the context table */
+    Rb_Info_t      rbInfo[MAX_BUFFER_HANDLE];   /**< Ring buffer information for each slot */
+    cU64_t         readyMap[READY_MAP_WORDS];   /**< One bit per slot, set while it holds unread data */
+    Rb_SchedInfo_t sched;                       /**< Ready buffer scheduler state */
+    Rb_Allocator_t allocator;                   /**< Allocator of buffers created without their own allocator */
+    Rb_Allocator_t contextAllocator;            /**< Allocator of the context itself */
+};
+
 /*****************************************************************************
  * VARIABLES
  *****************************************************************************/
-Rb_Info_t gRbInfo[MAX_BUFFER_HANDLE] = {0}; /**< Ring buffer information for each user */
+static Rb_Context_t gRbDefaultContext = {0}; /**< Context used by the APIs without a context argument */
+
+static Rb_Context_t *gRbContext[MAX_CONTEXTS] = {&gRbDefaultContext}; /**< Context of each context id */
+
+static cU32_t gRbGeneration = 0; /**< Last slot generation handed out, module wide so slots never repeat one */
+
+static void *defaultAlloc(cSize_t size, cSize_t alignment, void *context);
+
+static void *defaultRealloc(void *ptr, cSize_t oldSize, cSize_t newSize, cSize_t alignment, void *context);
+
+static void defaultFree(void *ptr, cSize_t size, void *context);
+
+static const Rb_Allocator_t gRbDefaultAllocator = {defaultAlloc, defaultRealloc, defaultFree, NULL}; /**< Heap allocator */
 
 /*****************************************************************************
  * FUNCTION DECLARATIONS
  *****************************************************************************/
 static cBool handleFragmentedPeek(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes);
 
+static cBool handleCompressedPeek(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes);
+
 static void handleFragmentedCommit(Rb_Info_t *rbInfo);
 
 static void advanceReader(Rb_Info_t *rbInfo, cU64_t dataBytes);
 
-static void resetBuffer(Rb_Info_t *rbInfo);
+static void compactWriter(Rb_Info_t *rbInfo);
+
+static cU64_t getRecordOffset(const Rb_Info_t *rbInfo, cU64_t baseOffset, cU64_t dataIndex);
+
+static cU64_t getUnreadIndexCount(Rb_Info_t *rbInfo);
+
+static cU64_t getUsedIndexCount(Rb_Info_t *rbInfo);
+
+static cU64_t getContiguousFreeSpace(Rb_Info_t *rbInfo);
+
+static cU64_t getFreeSpace(Rb_Info_t *rbInfo);
+
+static cU64_t getOccupiedSpace(Rb_Info_t *rbInfo);
+
+static void markBufferReady(cI32_t bufferHandle);
+
+static void clearBufferReady(cI32_t bufferHandle);
+
+static cI32_t findReadyHandle(Rb_Context_t *context, cI32_t startSlotId);
+
+static cBool verifyPeekedData(Rb_Info_t *rbInfo, const cU8_t *readPtr, cU64_t dataBytes);
+
+static cBool encodeRecord(Rb_Info_t *rbInfo, const cU8_t *data, cU64_t dataBytes, cU64_t *encodedBytes);
+
+static cU64_t getDecodeScratchBytes(const Rb_Info_t *rbInfo, cU64_t dataIndex);
+
+static cU64_t decodeRecord(const Rb_Info_t *rbInfo, cU64_t dataIndex, cU8_t *scratchBuf);
+
+static void consumeRecords(Rb_Info_t *rbInfo, cU64_t recordCnt);
 
-static cU64_t getUnreadIndexCount(cI32_t bufferHandle);
+static void dropOldestRetained(Rb_Info_t *rbInfo);
 
-static cU64_t getContiguousFreeSpace(cI32_t bufferHandle);
+static void publishWrites(Rb_Info_t *rbInfo);
 
-static cU64_t getFreeSpace(cI32_t bufferHandle);
+static void markGroupStart(Rb_Info_t *rbInfo);
 
-static cU64_t getOccupiedSpace(cI32_t bufferHandle) __attribute__((unused));
+static void prefetchRecords(Rb_Info_t *rbInfo);
+
+static void checkWatermarks(Rb_Info_t *laneInfo);
+
+static void applyRateLimit(Rb_Info_t *rbInfo, const Rb_RateLimit_t *rateLimit);
+
+static void refillTokenBucket(Rb_TokenBucket_t *bucket, cU64_t rate, cU64_t burst, cU64_t nowNs);
+
+static cBool takeRateTokens(Rb_Info_t *rbInfo, cU64_t dataBytes);
+
+static cBool writeRecord(Rb_Info_t *rbInfo, const cU8_t *data, cU64_t dataBytes, cU8_t tag, cU32_t userWord);
+
+static cBool peekRecord(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes, cBool decodeF);
+
+static cBool commitRecord(Rb_Info_t *rbInfo, cU64_t dataBytes);
+
+static void selectLane(cI32_t bufferHandle);
+
+static cBool peekBuffer(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes);
+
+static void seekLaneToTime(Rb_Info_t *rbInfo, cU64_t timeStampNs);
+
+static void skipFilteredLanes(Rb_Info_t *rbInfo);
+
+static void skipFilteredRecords(Rb_Info_t *rbInfo, cU64_t tagFilter, cU64_t expireBeforeNs);
+
+static cU64_t getTotalUnreadIndexCount(cI32_t bufferHandle);
+
+static void releaseBufferSlot(cI32_t bufferHandle);
+
+static cU32_t nextGeneration(void);
+
+static cBool growScratch(Rb_Info_t *rbInfo, cU8_t **scratchBuf, cU64_t *scratchSize, cU64_t needBytes);
+
+static void freeMemory(Rb_Info_t *rbInfo, cU8_t **pMemory, cU64_t size);
+
+static void trimScratch(Rb_Info_t *rbInfo);
+
+static void initContext(Rb_Context_t *context, const Rb_Allocator_t *allocator);
+
+static void releaseContextMemory(Rb_Context_t *context);
+
+static cBool isSpaceForRecord(Rb_Info_t *rbInfo, cU64_t dataBytes);
+
+static cBool checkSlotConsistency(Rb_Info_t *rbInfo);
 
 /*****************************************************************************
  * FUNCTION DEFINATIONS
@@ -98,21 +385,9 @@ static cU64_t getOccupiedSpace(cI32_t bufferHandle) __attribute__((unused));
  */
 void Rb_InitModule(void)
 {
-    cU8_t handleId = 0;
-    for (handleId = 0; handleId < MAX_BUFFER_HANDLE; handleId++)
-    {
-        gRbInfo[handleId].pBufferBegin = NULL;
-        gRbInfo[handleId].pWriter = NULL;
-        gRbInfo[handleId].pReader = NULL;
-        gRbInfo[handleId].size = 0;
-        gRbInfo[handleId].dataLen[0] = 0;
-        gRbInfo[handleId].readIndex = 0;
-        gRbInfo[handleId].writeIndex = 0;
-        gRbInfo[handleId].bufferHandle = INVALID_BUFFER_HANDLE;
-        gRbInfo[handleId].fragmentedDataF = c_FALSE;
-        gRbInfo[handleId].fragmentedDataPtr = NULL;
-        gRbInfo[handleId].readCommittedF = c_TRUE;
-    }
+    initContext(&gRbDefaultContext, NULL);
+    gRbDefaultContext.contextId = 0;
+    Crc32c_Init();
 }
 
 //----------------------------------------------------------------------------
@@ -121,19 +396,7 @@ void Rb_InitModule(void)
  */
 void Rb_DeinitModule(void)
 {
-    cU8_t handleId = 0;
-    for (handleId = 0; handleId < MAX_BUFFER_HANDLE; handleId++)
-    {
-        if (gRbInfo[handleId].pBufferBegin != NULL)
-        {
-            FREE_MEMORY(gRbInfo[handleId].pBufferBegin);
-        }
-
-        if (gRbInfo[handleId].fragmentedDataPtr != NULL)
-        {
-            FREE_MEMORY(gRbInfo[handleId].fragmentedDataPtr);
-        }
-    }
+    releaseContextMemory(&gRbDefaultContext);
 }
 
 //----------------------------------------------------------------------------
@@ -145,7 +408,44 @@ void Rb_DeinitModule(void)
  */
 cBool Rb_CreateBuffer(cU64_t bufferSizeInBytes, cI32_t *bufferHandle)
 {
-    cU8_t handleId = 0;
+    return Rb_CreateBufferWithAllocator(bufferSizeInBytes, NULL, bufferHandle);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get a buffer instance with the specified size, allocating all of its memory with the given allocator.
+ * @param bufferSizeInBytes Size of the buffer in bytes.
+ * @param allocator Allocator of the buffer, NULL to use the module allocator.
+ * @param bufferHandle Pointer to store the handle of the created buffer.
+ * @return cBool Returns c_TRUE if the buffer instance is created successfully, otherwise c_FALSE
+ * @note  The allocator is copied, it is used for the buffer memory, the scratch memory and the lanes of the
+ *        buffer until it is destroyed.
+ */
+cBool Rb_CreateBufferWithAllocator(cU64_t bufferSizeInBytes, const Rb_Allocator_t *allocator, cI32_t *bufferHandle)
+{
+    return Rb_CtxCreateBuffer(&gRbDefaultContext, bufferSizeInBytes, allocator, bufferHandle);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get a buffer instance with the specified size in the given context.
+ * @param context Context owning the buffer.
+ * @param bufferSizeInBytes Size of the buffer in bytes.
+ * @param allocator Allocator of the buffer, NULL to use the allocator of the context.
+ * @param bufferHandle Pointer to store the handle of the created buffer.
+ * @return cBool Returns c_TRUE if the buffer instance is created successfully, otherwise c_FALSE
+ * @note  The handle identifies the context, so all other buffer APIs take it without the context.
+ */
+cBool Rb_CtxCreateBuffer(Rb_Context_t *context, cU64_t bufferSizeInBytes, const Rb_Allocator_t *allocator,
+                         cI32_t *bufferHandle)
+{
+    cI32_t slotId;
+
+    if (context == NULL)
+    {
+        EPRINT("invalid context");
+        return c_FALSE;
+    }
 
     if (bufferSizeInBytes > MAX_ALLOWED_BUFFER_SIZE_IN_BYTES)
     {
@@ -153,27 +453,87 @@ cBool Rb_CreateBuffer(cU64_t bufferSizeInBytes, cI32_t *bufferHandle)
         return c_FALSE;
     }
 
-    for (handleId = 0; handleId < MAX_BUFFER_HANDLE; handleId++)
+    if (allocator == NULL)
+    {
+        allocator = &context->allocator;
+    }
+    else if ((allocator->allocFn == NULL) || (allocator->reallocFn == NULL) || (allocator->freeFn == NULL))
+    {
+        EPRINT("invalid allocator");
+        return c_FALSE;
+    }
+
+    for (slotId = 0; slotId < MAX_BUFFER_HANDLE; slotId++)
     {
-        if (gRbInfo[handleId].bufferHandle == INVALID_BUFFER_HANDLE)
+        if (context->rbInfo[slotId].bufferHandle == INVALID_BUFFER_HANDLE)
         {
-            gRbInfo[handleId].pBufferBegin = (cU8_t *)malloc(bufferSizeInBytes);
-            if (gRbInfo[handleId].pBufferBegin == NULL)
+            Rb_Info_t *rbInfo = &context->rbInfo[slotId];
+            cI32_t     handleId = MAKE_BUFFER_HANDLE(context->contextId, slotId);
+
+            rbInfo->allocator = *allocator;
+            rbInfo->pBufferBegin =
+                (cU8_t *)allocator->allocFn(bufferSizeInBytes, CACHE_LINE_BYTES, allocator->context);
+            if (rbInfo->pBufferBegin == NULL)
             {
                 EPRINT("failed to allocate memory for buffer");
                 return c_FALSE;
             }
 
-            gRbInfo[handleId].pWriter = gRbInfo[handleId].pBufferBegin;
-            gRbInfo[handleId].pReader = gRbInfo[handleId].pBufferBegin;
-            gRbInfo[handleId].dataLen[0] = 0;
-            gRbInfo[handleId].size = bufferSizeInBytes;
-            gRbInfo[handleId].readIndex = 0;
-            gRbInfo[handleId].writeIndex = 0;
-            gRbInfo[handleId].bufferHandle = handleId;
-            gRbInfo[handleId].fragmentedDataF = c_FALSE;
-            gRbInfo[handleId].fragmentedDataPtr = NULL;
-            gRbInfo[handleId].readCommittedF = c_TRUE;
+            rbInfo->writeOffset = 0;
+            rbInfo->readOffset = 0;
+            rbInfo->retainOffset = 0;
+            rbInfo->entry[0].dataLen = 0;
+            rbInfo->size = bufferSizeInBytes;
+            rbInfo->readIndex = 0;
+            rbInfo->writeIndex = 0;
+            rbInfo->bufferHandle = handleId;
+            rbInfo->fragmentedDataPtr = NULL;
+            rbInfo->fragmentedDataSize = 0;
+            rbInfo->fragmentedPeekF = c_FALSE;
+            rbInfo->readCommittedF = c_TRUE;
+            rbInfo->schedWeight = DEFAULT_SCHED_WEIGHT;
+            rbInfo->integrityMode = Rb_IntegrityMode_NONE;
+            rbInfo->codec = Rb_Codec_NONE;
+            rbInfo->codecBuf = NULL;
+            rbInfo->codecBufSize = 0;
+            rbInfo->timeStampF = c_FALSE;
+            rbInfo->ttlNs = 0;
+            rbInfo->nextSeq = 0;
+            rbInfo->oldestSeq = 0;
+            rbInfo->retainIndex = 0;
+            rbInfo->retainCount = 0;
+            rbInfo->retainRecords = 0;
+            rbInfo->replayBuf = NULL;
+            rbInfo->replayBufSize = 0;
+            rbInfo->pubWriteIndex = 0;
+            rbInfo->pubWriteOffset = 0;
+            rbInfo->pubSeq = 0;
+            rbInfo->publishRecords = DEFAULT_PUBLISH_RECORDS;
+            rbInfo->publishBytes = 0;
+            rbInfo->pendingRecords = 0;
+            rbInfo->pendingBytes = 0;
+            rbInfo->groupOpenF = c_FALSE;
+            rbInfo->releaseRecords = DEFAULT_RELEASE_RECORDS;
+            rbInfo->releasePending = 0;
+            rbInfo->prefetchDepth = 0;
+            rbInfo->highWatermark = 0;
+            rbInfo->lowWatermark = 0;
+            rbInfo->aboveHighF = c_FALSE;
+            rbInfo->watermarkCb = NULL;
+            rbInfo->watermarkUserData = NULL;
+            rbInfo->ownerHandle = handleId;
+            rbInfo->laneCnt = 1;
+            rbInfo->laneHandle[0] = handleId;
+            rbInfo->lanePolicy = Rb_LanePolicy_STRICT;
+            rbInfo->peekLane = rbInfo;
+            rbInfo->wrapPolicy = Rb_WrapPolicy_SPLIT;
+            rbInfo->compactOnEmptyF = c_TRUE;
+            rbInfo->compactOffset = 0;
+            rbInfo->tagFilter = ALL_TAGS;
+            rbInfo->rateLimitF = c_FALSE;
+            rbInfo->writeStatus = cStatus_SUCCESS;
+            memset(&rbInfo->stats, 0, sizeof(rbInfo->stats));
+            clearBufferReady(handleId);
 
             *bufferHandle = handleId;
             return c_TRUE;
@@ -184,6 +544,139 @@ cBool Rb_CreateBuffer(cU64_t bufferSizeInBytes, cI32_t *bufferHandle)
     return c_FALSE;  // No available buffer handle
 }
 
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the allocator used by buffers created afterwards without their own allocator.
+ * @param allocator Allocator of the module, NULL to restore the default heap allocator.
+ * @return cBool Returns c_TRUE if the allocator is set successfully, otherwise c_FALSE
+ * @note  Set it right after Rb_InitModule. Existing buffers keep the allocator they were created with.
+ */
+cBool Rb_SetModuleAllocator(const Rb_Allocator_t *allocator)
+{
+    return Rb_CtxSetAllocator(&gRbDefaultContext, allocator);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Create an independent context with its own buffer handles, scheduler and allocator.
+ * @param allocator Allocator of the context and of its buffers, NULL to use the heap.
+ * @param context Pointer to store the created context.
+ * @return cBool Returns c_TRUE if the context is created successfully, otherwise c_FALSE
+ * @note  Buffers of different contexts share no state, so independent subsystems or threads do not compete
+ *        for handles. Rb_InitModule must be called once before.
+ */
+cBool Rb_CreateContext(const Rb_Allocator_t *allocator, Rb_Context_t **context)
+{
+    Rb_Context_t *newContext;
+    cI32_t        contextId;
+
+    if (context == NULL)
+    {
+        EPRINT("invalid context pointer");
+        return c_FALSE;
+    }
+
+    if (allocator == NULL)
+    {
+        allocator = &gRbDefaultAllocator;
+    }
+    else if ((allocator->allocFn == NULL) || (allocator->reallocFn == NULL) || (allocator->freeFn == NULL))
+    {
+        EPRINT("invalid allocator");
+        return c_FALSE;
+    }
+
+    newContext = (Rb_Context_t *)allocator->allocFn(sizeof(Rb_Context_t), CACHE_LINE_BYTES, allocator->context);
+    if (newContext == NULL)
+    {
+        EPRINT("failed to allocate memory for context");
+        return c_FALSE;
+    }
+
+    initContext(newContext, allocator);
+
+    for (contextId = 1; contextId < MAX_CONTEXTS; contextId++)
+    {
+        Rb_Context_t *freeContext = NULL;
+
+        // Handles are only built when buffers are created, so the id is all that depends on the claimed entry
+        newContext->contextId = contextId;
+
+        // Claim the context id atomically, contexts may be created from several threads
+        if (__atomic_compare_exchange_n(&gRbContext[contextId], &freeContext, newContext, c_FALSE, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED) == c_TRUE)
+        {
+            *context = newContext;
+            return c_TRUE;
+        }
+    }
+
+    allocator->freeFn(newContext, sizeof(Rb_Context_t), allocator->context);
+    EPRINT("maximum contexts reached: [maxContexts=%d]", MAX_CONTEXTS);
+    return c_FALSE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Destroy a context created by Rb_CreateContext, releasing all of its buffers.
+ * @param context Pointer to the context, set to NULL on success.
+ * @return cBool Returns c_TRUE if the context is destroyed successfully, otherwise c_FALSE
+ * @note  Handles of the context become invalid.
+ */
+cBool Rb_DestroyContext(Rb_Context_t **context)
+{
+    Rb_Context_t  *oldContext;
+    Rb_Allocator_t contextAllocator;
+
+    if ((context == NULL) || (*context == NULL) || (*context == &gRbDefaultContext))
+    {
+        EPRINT("invalid context");
+        return c_FALSE;
+    }
+
+    oldContext = *context;
+    releaseContextMemory(oldContext);
+    __atomic_store_n(&gRbContext[oldContext->contextId], NULL, __ATOMIC_RELEASE);
+
+    contextAllocator = oldContext->contextAllocator;
+    contextAllocator.freeFn(oldContext, sizeof(Rb_Context_t), contextAllocator.context);
+    *context = NULL;
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the allocator used by buffers of the context created afterwards without their own allocator.
+ * @param context Context to set the allocator of.
+ * @param allocator Allocator of the context buffers, NULL to restore the default heap allocator.
+ * @return cBool Returns c_TRUE if the allocator is set successfully, otherwise c_FALSE
+ * @note  Existing buffers keep the allocator they were created with.
+ */
+cBool Rb_CtxSetAllocator(Rb_Context_t *context, const Rb_Allocator_t *allocator)
+{
+    if (context == NULL)
+    {
+        EPRINT("invalid context");
+        return c_FALSE;
+    }
+
+    if (allocator == NULL)
+    {
+        context->allocator = gRbDefaultAllocator;
+        return c_TRUE;
+    }
+
+    if ((allocator->allocFn == NULL) || (allocator->reallocFn == NULL) || (allocator->freeFn == NULL))
+    {
+        EPRINT("invalid allocator");
+        return c_FALSE;
+    }
+
+    context->allocator = *allocator;
+    return c_TRUE;
+}
+
 //----------------------------------------------------------------------------
 /**
  * @brief Destroy the buffer instance associated with the given handle.
@@ -204,21 +697,16 @@ cBool Rb_DestroyBuffer(cI32_t *bufferHandle)
         return c_FALSE;
     }
 
-    Rb_Info_t *rbInfo = &gRbInfo[(*bufferHandle)];
-
-    if (rbInfo->pBufferBegin != NULL)
-    {
-        FREE_MEMORY(rbInfo->pBufferBegin);
-        rbInfo->pBufferBegin = NULL;
-    }
+    Rb_Info_t *rbInfo = &RB_INFO(*bufferHandle);
+    cU32_t     laneId;
 
-    if (rbInfo->fragmentedDataPtr != NULL)
+    for (laneId = 1; laneId < rbInfo->laneCnt; laneId++)
     {
-        FREE_MEMORY(rbInfo->fragmentedDataPtr);
-        rbInfo->fragmentedDataPtr = NULL;
+        releaseBufferSlot(rbInfo->laneHandle[laneId]);
     }
 
-    rbInfo->bufferHandle = INVALID_BUFFER_HANDLE;
+    rbInfo->laneCnt = 1;
+    releaseBufferSlot(*bufferHandle);
     *bufferHandle = INVALID_BUFFER_HANDLE;
 
     return c_TRUE;
@@ -228,11 +716,19 @@ cBool Rb_DestroyBuffer(cI32_t *bufferHandle)
 /**
  * @brief Get the count of unread indices in the buffer.
  * @param bufferHandle Handle of the buffer.
- * @return cU64_t Returns the count of unread indices in the buffer.
+ * @return cU64_t Returns the count of unread indices in the buffer, summed over all of its lanes, 0 for an
+ *         invalid handle.
  */
 cU64_t Rb_GetUnreadIndexCount(cI32_t bufferHandle)
 {
-    return getUnreadIndexCount(bufferHandle);
+    // Handle may belong to a destroyed context, whose slot table is gone
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return 0;
+    }
+
+    return getTotalUnreadIndexCount(bufferHandle);
 }
 
 //----------------------------------------------------------------------------
@@ -256,7 +752,7 @@ cBool Rb_GetFreeSpace(cI32_t bufferHandle, cU64_t *freeSpace)
         return c_FALSE;
     }
 
-    *freeSpace = getFreeSpace(bufferHandle);
+    *freeSpace = getFreeSpace(&RB_INFO(bufferHandle));
     return c_TRUE;
 }
 
@@ -282,56 +778,80 @@ cBool Rb_WriteToBuffer(cI32_t bufferHandle, const cU8_t *data, cU64_t dataBytes)
         return c_FALSE;
     }
 
-    Rb_Info_t   *rbInfo = &gRbInfo[bufferHandle];
-    cU64_t       totalFreeSpace = getFreeSpace(bufferHandle);
-    cU64_t       contiguousFreeSpace = getContiguousFreeSpace(bufferHandle);
-    const cU8_t *tDataPtr = data;
+    return writeRecord(&RB_INFO(bufferHandle), data, dataBytes, 0, 0);
+}
 
-    if (getUnreadIndexCount(bufferHandle) >= MAX_DATA_INDEX)
+//----------------------------------------------------------------------------
+/**
+ * @brief Write a record with a type tag to the buffer.
+ * @param bufferHandle Handle of the buffer to write to.
+ * @param tag Type tag of the record, 0 to 63. Records written without a tag have tag 0.
+ * @param data Pointer to the data to write.
+ * @param dataBytes Size of the data in bytes.
+ * @return cBool Returns c_TRUE if the data is written successfully, otherwise c_FALSE.
+ */
+cBool Rb_WriteTaggedToBuffer(cI32_t bufferHandle, cU8_t tag, const cU8_t *data, cU64_t dataBytes)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
     {
-        EPRINT("max data index reached");
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
         return c_FALSE;
     }
 
-    if (totalFreeSpace < dataBytes)
+    if (tag >= TAG_CNT)
     {
-        EPRINT("not enough free space in buffer: [dataBytes=%lu], [freeSpace=%lu]", dataBytes, totalFreeSpace);
+        EPRINT("invalid tag: [tag=%u], [maxTag=%d]", tag, TAG_CNT - 1);
         return c_FALSE;
     }
 
-    if (contiguousFreeSpace < dataBytes)
+    if ((dataBytes == 0) || (data == NULL))
     {
-        memcpy(rbInfo->pWriter, tDataPtr, contiguousFreeSpace);
-        rbInfo->dataLen[rbInfo->writeIndex] = contiguousFreeSpace;
-        rbInfo->writeIndex++;
+        EPRINT("invalid data or data size: [dataBytes=%lu]", dataBytes);
+        return c_FALSE;
+    }
 
-        if (rbInfo->writeIndex == MAX_DATA_INDEX)
-        {
-            // Wrap around
-            rbInfo->writeIndex = 0;
-        }
+    return writeRecord(&RB_INFO(bufferHandle), data, dataBytes, tag, 0);
+}
 
-        // Update pointer and size to write remaining data
-        tDataPtr += contiguousFreeSpace;
-        dataBytes -= contiguousFreeSpace;
+//----------------------------------------------------------------------------
+/**
+ * @brief Write a record with a type tag and a user word to a priority lane of the buffer.
+ * @param bufferHandle Handle of the buffer to write to.
+ * @param laneId Lane to write to, lane 0 is the same as the buffer.
+ * @param tag Type tag of the record, 0 to 63.
+ * @param userWord Opaque word stored in the index entry of the record, read back with Rb_GetPeekUserWord.
+ * @param data Pointer to the data to write.
+ * @param dataBytes Size of the data in bytes.
+ * @return cBool Returns c_TRUE if the data is written successfully, otherwise c_FALSE.
+ */
+cBool Rb_WriteTaggedToLane(cI32_t bufferHandle, cU32_t laneId, cU8_t tag, cU32_t userWord, const cU8_t *data,
+                           cU64_t dataBytes)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
 
-        // Wrap around
-        rbInfo->pWriter = rbInfo->pBufferBegin;
-        rbInfo->fragmentedDataF = c_TRUE;
+    if (laneId >= RB_INFO(bufferHandle).laneCnt)
+    {
+        EPRINT("invalid lane: [laneId=%u], [laneCnt=%u]", laneId, RB_INFO(bufferHandle).laneCnt);
+        return c_FALSE;
     }
 
-    memcpy(rbInfo->pWriter, tDataPtr, dataBytes);
-    rbInfo->dataLen[rbInfo->writeIndex] = dataBytes;
-    rbInfo->writeIndex++;
-    rbInfo->pWriter += dataBytes;
+    if (tag >= TAG_CNT)
+    {
+        EPRINT("invalid tag: [tag=%u], [maxTag=%d]", tag, TAG_CNT - 1);
+        return c_FALSE;
+    }
 
-    if (rbInfo->writeIndex == MAX_DATA_INDEX)
+    if ((dataBytes == 0) || (data == NULL))
     {
-        // Wrap around
-        rbInfo->writeIndex = 0;
+        EPRINT("invalid data or data size: [dataBytes=%lu]", dataBytes);
+        return c_FALSE;
     }
 
-    return c_TRUE;
+    return writeRecord(&RB_INFO(RB_INFO(bufferHandle).laneHandle[laneId]), data, dataBytes, tag, userWord);
 }
 
 //----------------------------------------------------------------------------
@@ -341,6 +861,10 @@ cBool Rb_WriteToBuffer(cI32_t bufferHandle, const cU8_t *data, cU64_t dataBytes)
  * @param data Pointer to store the read data.
  * @param dataBytes Pointer to store the size of the read data in bytes.
  * @return cBool Returns c_TRUE if the data is read successfully, otherwise c_FALSE.
+ * @note  With Rb_IntegrityMode_VERIFY_ON_PEEK a checksum mismatch returns c_FALSE with readPtr and dataBytes
+ *        still set, commit the read to skip the corrupted record. Compressed records are decoded into the
+ *        reassembly memory, so the record and its size are the ones written, a record that does not decode is
+ *        reported and skipped the same way.
  */
 cBool Rb_PeekRead(cI32_t bufferHandle, cU8_t **readPtr, cU64_t *dataBytes)
 {
@@ -356,42 +880,62 @@ cBool Rb_PeekRead(cI32_t bufferHandle, cU8_t **readPtr, cU64_t *dataBytes)
         return c_FALSE;
     }
 
-    Rb_Info_t *rbInfo = &gRbInfo[bufferHandle];
+    return peekBuffer(&RB_INFO(bufferHandle), readPtr, dataBytes);
+}
 
-    if (rbInfo->readCommittedF == c_FALSE)
-    {
-        EPRINT("previous read not committed");
+//----------------------------------------------------------------------------
+/**
+ * @brief Commit the read operation from the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @param dataBytes Size of the data read in bytes.
+ * @return cBool Returns c_TRUE if the read is committed successfully, otherwise c_FALSE
+ */
+cBool Rb_CommitRead(cI32_t bufferHandle, cU64_t dataBytes)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
         return c_FALSE;
     }
 
-    rbInfo->readCommittedF = c_FALSE;
+    return commitRecord(RB_INFO(bufferHandle).peekLane, dataBytes);
+}
 
-    if (rbInfo->dataLen[rbInfo->readIndex] == 0)
+//----------------------------------------------------------------------------
+/**
+ * @brief Subscribe the reader of the buffer to a set of record tags.
+ * @param bufferHandle Handle of the buffer.
+ * @param tagFilter One bit per tag, bit n serves records with tag n. All bits set serves every record.
+ * @return cBool Returns c_TRUE if the filter is set successfully, otherwise c_FALSE
+ * @note  Peek and copy reads consume records with other tags without touching their payload. Skipped records
+ *        are counted in Rb_Stats_t and stay available for replay within the retention window.
+ */
+cBool Rb_SetTagFilter(cI32_t bufferHandle, cU64_t tagFilter)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
     {
-        EPRINT("no data available to read");
-        *dataBytes = 0;
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
         return c_FALSE;
     }
 
-    // Check if reading fragmented data
-    if (IS_DATA_FRAGMENTED(rbInfo))
+    if (tagFilter == 0)
     {
-       return handleFragmentedPeek(rbInfo, readPtr, dataBytes);
+        EPRINT("tag filter serves no records: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
     }
 
-    *readPtr = rbInfo->pReader;
-    *dataBytes = rbInfo->dataLen[rbInfo->readIndex];
+    RB_INFO(bufferHandle).tagFilter = tagFilter;
     return c_TRUE;
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Commit the read operation from the buffer.
+ * @brief Get the tag of the record returned by the last peek read.
  * @param bufferHandle Handle of the buffer.
- * @param dataBytes Size of the data read in bytes.
- * @return cBool Returns c_TRUE if the read is committed successfully, otherwise c_FALSE
+ * @param tag Pointer to store the tag.
+ * @return cBool Returns c_TRUE if the tag is retrieved successfully, otherwise c_FALSE
  */
-cBool Rb_CommitRead(cI32_t bufferHandle, cU64_t dataBytes)
+cBool Rb_GetPeekTag(cI32_t bufferHandle, cU8_t *tag)
 {
     if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
     {
@@ -399,207 +943,3363 @@ cBool Rb_CommitRead(cI32_t bufferHandle, cU64_t dataBytes)
         return c_FALSE;
     }
 
-    Rb_Info_t *rbInfo = &gRbInfo[bufferHandle];
+    if (tag == NULL)
+    {
+        EPRINT("invalid tag pointer");
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = RB_INFO(bufferHandle).peekLane;
 
     if (rbInfo->readCommittedF == c_TRUE)
     {
-        EPRINT("no peek read has been performed");
+        EPRINT("no peek read has been performed: [bufferHandle=%d]", bufferHandle);
         return c_FALSE;
     }
 
-    rbInfo->readCommittedF = c_TRUE;
+    *tag = rbInfo->peekTag;
+    return c_TRUE;
+}
 
-    if (dataBytes == 0)
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the user word of the record returned by the last peek read.
+ * @param bufferHandle Handle of the buffer.
+ * @param userWord Pointer to store the user word, 0 for records written without one.
+ * @return cBool Returns c_TRUE if the user word is retrieved successfully, otherwise c_FALSE
+ */
+cBool Rb_GetPeekUserWord(cI32_t bufferHandle, cU32_t *userWord)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
     {
-        EPRINT("invalid data size: [dataBytes=%lu]", dataBytes);
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
         return c_FALSE;
     }
 
-    /* Note: If the data was fragmented during write, we allocated memory to hold the fragmented data
-     *       during peek read, so we will just free that memory during commit read and return as all
-     *       pointers & indices are already updated in peek read.
-     */
-    if (rbInfo->fragmentedDataPtr != NULL)
+    if (userWord == NULL)
     {
-        handleFragmentedCommit(rbInfo);
+        EPRINT("invalid user word pointer");
+        return c_FALSE;
     }
-    else
+
+    Rb_Info_t *rbInfo = RB_INFO(bufferHandle).peekLane;
+
+    if (rbInfo->readCommittedF == c_TRUE)
     {
-        if (dataBytes != rbInfo->dataLen[rbInfo->readIndex])
-        {
-            EPRINT("data size to commit does not match the peeked data size: [dataBytes=%lu], [peekedDataSize=%lu]", dataBytes,
-                   rbInfo->dataLen[rbInfo->readIndex]);
-            return c_FALSE;
-        }
+        EPRINT("no peek read has been performed: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
 
-        advanceReader(rbInfo, dataBytes);
+    *userWord = rbInfo->peekUserWord;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Resolve a buffer handle once for the data path APIs taking a reference.
+ * @param bufferHandle Handle of the buffer.
+ * @param ref Pointer to store the reference, typically kept by a worker thread for its lifetime.
+ * @return cBool Returns c_TRUE if the handle is resolved successfully, otherwise c_FALSE
+ * @note  The reference is invalidated when the buffer is destroyed. It must not be used after the context
+ *        of the buffer has been destroyed.
+ */
+cBool Rb_Acquire(cI32_t bufferHandle, Rb_Ref_t *ref)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
     }
 
-    if (IS_BUFFER_EMPTY(bufferHandle))
+    if (ref == NULL)
     {
-        // All data has been read, reset indices and pointers
-        resetBuffer(rbInfo);
+        EPRINT("invalid reference pointer");
+        return c_FALSE;
     }
 
+    ref->info = &RB_INFO(bufferHandle);
+    ref->bufferHandle = bufferHandle;
+    ref->generation = RB_INFO(bufferHandle).generation;
     return c_TRUE;
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Handle reading fragmented data from the buffer.
- * @param rbInfo Pointer to the ring buffer information.
- * @param readPtr Pointer to store the read pointer.
- * @param dataBytes Pointer to store the size of the read data in bytes.
- * @return cBool Returns c_TRUE if the fragmented data is handled successfully, otherwise c_FALSE.
+ * @brief Drop a reference acquired by Rb_Acquire.
+ * @param ref Pointer to the reference.
+ * @return cBool Returns c_TRUE if the reference is released successfully, otherwise c_FALSE
  */
-static cBool handleFragmentedPeek(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes)
+cBool Rb_Release(Rb_Ref_t *ref)
 {
-    cU64_t part1Bytes, part2Bytes;
+    if (ref == NULL)
+    {
+        EPRINT("invalid reference pointer");
+        return c_FALSE;
+    }
 
-    part1Bytes = rbInfo->dataLen[rbInfo->readIndex];
-    rbInfo->dataLen[rbInfo->readIndex] = 0;
-    rbInfo->readIndex++;
+    ref->info = NULL;
+    ref->bufferHandle = INVALID_BUFFER_HANDLE;
+    ref->generation = 0;
+    return c_TRUE;
+}
 
-    if (rbInfo->readIndex == MAX_DATA_INDEX)
+//----------------------------------------------------------------------------
+/**
+ * @brief Write data to the buffer of a reference, same as Rb_WriteToBuffer without the handle lookup.
+ * @param ref Reference acquired by Rb_Acquire.
+ * @param data Pointer to the data to write.
+ * @param dataBytes Size of the data in bytes.
+ * @return cBool Returns c_TRUE if the data is written successfully, otherwise c_FALSE.
+ */
+cBool Rb_RefWriteToBuffer(const Rb_Ref_t *ref, const cU8_t *data, cU64_t dataBytes)
+{
+    if (IS_VALID_REF(ref) == c_FALSE)
     {
-        // Wrap around
-        rbInfo->readIndex = 0;
+        EPRINT("invalid buffer reference");
+        return c_FALSE;
     }
 
-    part2Bytes = rbInfo->dataLen[rbInfo->readIndex];
-    rbInfo->dataLen[rbInfo->readIndex] = 0;
-    rbInfo->readIndex++;
+    if ((dataBytes == 0) || (data == NULL))
+    {
+        EPRINT("invalid data or data size: [dataBytes=%lu]", dataBytes);
+        return c_FALSE;
+    }
 
-    // Allocate memory to hold the fragmented data
-    rbInfo->fragmentedDataPtr = (cU8_t *)malloc(part1Bytes + part2Bytes);
+    return writeRecord((Rb_Info_t *)ref->info, data, dataBytes, 0, 0);
+}
 
-    if (rbInfo->fragmentedDataPtr == NULL)
+//----------------------------------------------------------------------------
+/**
+ * @brief Read data from the buffer of a reference, same as Rb_PeekRead without the handle lookup.
+ * @param ref Reference acquired by Rb_Acquire.
+ * @param readPtr Pointer to store the read pointer.
+ * @param dataBytes Pointer to store the size of the read data in bytes.
+ * @return cBool Returns c_TRUE if the data is read successfully, otherwise c_FALSE.
+ */
+cBool Rb_RefPeekRead(const Rb_Ref_t *ref, cU8_t **readPtr, cU64_t *dataBytes)
+{
+    if (IS_VALID_REF(ref) == c_FALSE)
     {
-        EPRINT("failed to allocate memory for reading fragmented data");
+        EPRINT("invalid buffer reference");
         return c_FALSE;
     }
 
-    // Copy fragmented data into the allocated memory
-    memcpy(rbInfo->fragmentedDataPtr, rbInfo->pReader, part1Bytes);
-    rbInfo->pReader = rbInfo->pBufferBegin;
-    memcpy((rbInfo->fragmentedDataPtr + part1Bytes), rbInfo->pReader, part2Bytes);
-    rbInfo->pReader += part2Bytes;
-
-    *readPtr = rbInfo->fragmentedDataPtr;
-    *dataBytes = (part1Bytes + part2Bytes);
+    if ((dataBytes == NULL) || (readPtr == NULL))
+    {
+        EPRINT("invalid data pointer");
+        return c_FALSE;
+    }
 
-    return c_TRUE;
+    return peekBuffer((Rb_Info_t *)ref->info, readPtr, dataBytes);
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Handle committing a read of fragmented data.
- * @param rbInfo Pointer to the ring buffer information.
+ * @brief Commit the read operation from the buffer of a reference, same as Rb_CommitRead without the handle
+ *        lookup.
+ * @param ref Reference acquired by Rb_Acquire.
+ * @param dataBytes Size of the data read in bytes.
+ * @return cBool Returns c_TRUE if the read is committed successfully, otherwise c_FALSE
  */
-static void handleFragmentedCommit(Rb_Info_t *rbInfo)
+cBool Rb_RefCommitRead(const Rb_Ref_t *ref, cU64_t dataBytes)
 {
-    FREE_MEMORY(rbInfo->fragmentedDataPtr);
-    rbInfo->fragmentedDataF = c_FALSE;
+    Rb_Info_t *rbInfo;
+
+    if (IS_VALID_REF(ref) == c_FALSE)
+    {
+        EPRINT("invalid buffer reference");
+        return c_FALSE;
+    }
+
+    rbInfo = (Rb_Info_t *)ref->info;
+    if (rbInfo->laneCnt > 1)
+    {
+        return commitRecord(rbInfo->peekLane, dataBytes);
+    }
+
+    return commitRecord(rbInfo, dataBytes);
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Advance the reader pointer and index after committing a read.
- * @param rbInfo Pointer to the ring buffer information.
- * @param dataBytes Size of the data read in bytes.
+ * @brief Read the next record into the user provided memory and commit it.
+ * @param bufferHandle Handle of the buffer to read from.
+ * @param outBuf Pointer to the memory to copy the record into.
+ * @param outBufSize Size of the memory in bytes.
+ * @param dataBytes Pointer to store the size of the record in bytes.
+ * @return cBool Returns c_TRUE if the record is read successfully, otherwise c_FALSE
+ * @note  Compressed records are decompressed into outBuf. If outBuf is too small the record is not consumed
+ *        and dataBytes is set to the required size.
  */
-static void advanceReader(Rb_Info_t *rbInfo, cU64_t dataBytes)
+cBool Rb_ReadToBuffer(cI32_t bufferHandle, cU8_t *outBuf, cU64_t outBufSize, cU64_t *dataBytes)
 {
-    rbInfo->dataLen[rbInfo->readIndex] = 0;
-    rbInfo->pReader += dataBytes;
-    rbInfo->readIndex++;
+    cU8_t *readPtr = NULL;
+    cU64_t storedBytes = 0;
+    cU8_t  recordFlags;
 
-    if (rbInfo->readIndex == MAX_DATA_INDEX)
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
     {
-        rbInfo->readIndex = 0;
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((outBuf == NULL) || (dataBytes == NULL))
+    {
+        EPRINT("invalid data pointer");
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if (rbInfo->peekLane->readCommittedF == c_FALSE)
+    {
+        EPRINT("previous read not committed");
+        return c_FALSE;
+    }
+
+    if ((rbInfo->tagFilter != ALL_TAGS) || (rbInfo->ttlNs != 0))
+    {
+        skipFilteredLanes(rbInfo);
+    }
+
+    if (rbInfo->laneCnt > 1)
+    {
+        selectLane(bufferHandle);
     }
+
+    Rb_Info_t *laneInfo = rbInfo->peekLane;
+
+    if (IS_NO_DATA_TO_READ(laneInfo))
+    {
+        *dataBytes = 0;
+        return c_FALSE;
+    }
+
+    recordFlags = laneInfo->entry[laneInfo->readIndex].flags;
+    *dataBytes = laneInfo->entry[laneInfo->readIndex].rawLen;
+
+    if (*dataBytes > outBufSize)
+    {
+        EPRINT("output buffer too small: [dataBytes=%lu], [outBufSize=%lu]", *dataBytes, outBufSize);
+        return c_FALSE;
+    }
+
+    // Compressed records are decoded straight into outBuf, not through the reassembly memory
+    if (peekRecord(laneInfo, &readPtr, &storedBytes, c_FALSE) == c_FALSE)
+    {
+        if (storedBytes != 0)
+        {
+            // Drop the corrupted record
+            commitRecord(laneInfo, storedBytes);
+        }
+
+        return c_FALSE;
+    }
+
+    if (recordFlags & RECORD_FLAG_COMPRESSED)
+    {
+        if (Lz_Decompress(readPtr, storedBytes, outBuf, outBufSize) != *dataBytes)
+        {
+            EPRINT("failed to decompress record: [bufferHandle=%d], [storedBytes=%lu]", bufferHandle, storedBytes);
+            commitRecord(laneInfo, storedBytes);
+            return c_FALSE;
+        }
+
+        // Checksum covers the record as written, so it is only comparable once decoded
+        if ((laneInfo->integrityMode == Rb_IntegrityMode_VERIFY_ON_PEEK) &&
+            (verifyPeekedData(laneInfo, outBuf, *dataBytes) == c_FALSE))
+        {
+            commitRecord(laneInfo, storedBytes);
+            return c_FALSE;
+        }
+    }
+    else
+    {
+        memcpy(outBuf, readPtr, storedBytes);
+    }
+
+    return commitRecord(laneInfo, storedBytes);
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Reset the buffer pointers and indices.
- * @param rbInfo Pointer to the ring buffer information.
+ * @brief Release the scratch memory the buffer keeps for reassembly, replay and compression.
+ * @param bufferHandle Handle of the buffer.
+ * @return cBool Returns c_TRUE if the memory is released successfully, otherwise c_FALSE
+ * @note  Scratch memory grows geometrically to the largest record seen and is reused, so steady state reads
+ *        and writes make no allocator calls. Call this after a burst of large records to give the memory back,
+ *        it is allocated again on demand. Not allowed while a read is outstanding, as the peeked record may
+ *        live in the reassembly memory.
  */
-static void resetBuffer(Rb_Info_t *rbInfo)
+cBool Rb_TrimMemory(cI32_t bufferHandle)
 {
-    rbInfo->pReader = rbInfo->pBufferBegin;
-    rbInfo->pWriter = rbInfo->pBufferBegin;
-    rbInfo->readIndex = 0;
-    rbInfo->writeIndex = 0;
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if (rbInfo->peekLane->readCommittedF == c_FALSE)
+    {
+        EPRINT("previous read not committed");
+        return c_FALSE;
+    }
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        trimScratch(&RB_INFO(rbInfo->laneHandle[laneId]));
+    }
+
+    return c_TRUE;
 }
 
-//------------------------------------------------------------------------------
+//----------------------------------------------------------------------------
 /**
- * @brief Check if there is a free data index available in the buffer.
+ * @brief Set how records that do not fit before the end of the buffer are placed.
  * @param bufferHandle Handle of the buffer.
- * @return cBool Returns c_TRUE if a free data index is available, otherwise c_FALSE
+ * @param wrapPolicy Wrap policy.
+ * @return cBool Returns c_TRUE if the policy is set successfully, otherwise c_FALSE
+ * @note  Rb_WrapPolicy_PAD keeps every record contiguous, so peek never copies, at the cost of the padding
+ *        bytes and of rejecting a record that only fits split. Compare paddingBytes and fragmentedRecords of
+ *        Rb_GetStats to pick the policy for a workload. Records are placed individually, so the policy can be
+ *        changed at any time. Applies to all lanes of the buffer.
  */
-static cU64_t getUnreadIndexCount(cI32_t bufferHandle)
+cBool Rb_SetWrapPolicy(cI32_t bufferHandle, Rb_WrapPolicy_e wrapPolicy)
 {
-    Rb_Info_t *rbInfo = &gRbInfo[bufferHandle];
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
 
-    if (rbInfo->readIndex > rbInfo->writeIndex)
+    if ((wrapPolicy != Rb_WrapPolicy_SPLIT) && (wrapPolicy != Rb_WrapPolicy_PAD))
     {
-        return (MAX_DATA_INDEX - (rbInfo->readIndex - rbInfo->writeIndex));
+        EPRINT("invalid wrap policy: [wrapPolicy=%d]", wrapPolicy);
+        return c_FALSE;
     }
-    else
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
     {
-        return (rbInfo->writeIndex - rbInfo->readIndex);
+        RB_INFO(rbInfo->laneHandle[laneId]).wrapPolicy = wrapPolicy;
     }
+
+    return c_TRUE;
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Get contiguous free size in the buffer.
+ * @brief Enable or disable starting over at the beginning of the buffer once it drained.
  * @param bufferHandle Handle of the buffer.
- * @return cU64_t Returns the free size in bytes.
+ * @param compactF c_TRUE to let the first write into an empty buffer start at the beginning, c_FALSE to keep
+ *                 writing where the last record ended.
+ * @return cBool Returns c_TRUE if the setting is applied successfully, otherwise c_FALSE
+ * @note  Only the writer acts on it: it moves its own offset to the next lap, and the consumer finds the next
+ *        record through the index like after padding, so no cursor is ever rewound.
+ *        Applies to all lanes of the buffer, lanes created later inherit the setting.
  */
-static cU64_t getContiguousFreeSpace(cI32_t bufferHandle)
+cBool Rb_SetCompactOnEmpty(cI32_t bufferHandle, cBool compactF)
 {
-    Rb_Info_t *rbInfo = &gRbInfo[bufferHandle];
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (IS_VALID_BOOL(compactF) == c_FALSE)
+    {
+        EPRINT("invalid compact flag: [compactF=%d]", compactF);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
 
-    if (rbInfo->pWriter < rbInfo->pReader)
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
     {
-        return (rbInfo->pReader - rbInfo->pWriter);
+        RB_INFO(rbInfo->laneHandle[laneId]).compactOnEmptyF = compactF;
     }
 
-    return ((rbInfo->pBufferBegin + rbInfo->size) - rbInfo->pWriter);
+    return c_TRUE;
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Get free size in the buffer.
+ * @brief Get the cumulative statistics of the buffer.
  * @param bufferHandle Handle of the buffer.
- * @return cU64_t Returns the free size in bytes.
+ * @param stats Pointer to store the statistics, summed over all lanes of the buffer.
+ * @return cBool Returns c_TRUE if the statistics are retrieved successfully, otherwise c_FALSE
  */
-static cU64_t getFreeSpace(cI32_t bufferHandle)
+cBool Rb_GetStats(cI32_t bufferHandle, Rb_Stats_t *stats)
 {
-    Rb_Info_t *rbInfo = &gRbInfo[bufferHandle];
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (stats == NULL)
+    {
+        EPRINT("invalid stats pointer");
+        return c_FALSE;
+    }
+
+    memset(stats, 0, sizeof(*stats));
 
-    if (rbInfo->pWriter < rbInfo->pReader)
+    for (laneId = 0; laneId < RB_INFO(bufferHandle).laneCnt; laneId++)
     {
-        return (rbInfo->pReader - rbInfo->pWriter);
+        Rb_Stats_t *laneStats = &RB_INFO(RB_INFO(bufferHandle).laneHandle[laneId]).stats;
+
+        stats->fragmentedRecords += laneStats->fragmentedRecords;
+        stats->paddedRecords += laneStats->paddedRecords;
+        stats->paddingBytes += laneStats->paddingBytes;
+        stats->skippedRecords += laneStats->skippedRecords;
+        stats->throttledRecords += laneStats->throttledRecords;
+        stats->expiredRecords += laneStats->expiredRecords;
     }
 
-    return (rbInfo->size - (rbInfo->pWriter - rbInfo->pReader));
+    return c_TRUE;
 }
 
 //----------------------------------------------------------------------------
 /**
- * @brief Get occupied size in the buffer.
+ * @brief Split the buffer into priority lanes, each its own ring sharing the handle and ready bit.
  * @param bufferHandle Handle of the buffer.
- * @return cU64_t Returns the occupied size in bytes.
+ * @param laneCnt Number of lanes including lane 0, 1 removes the extra lanes.
+ * @param laneSizeInBytes Size of each extra lane in bytes, lane 0 keeps the memory of the buffer.
+ * @param lanePolicy Policy used to pick the lane served by peek read.
+ * @return cBool Returns c_TRUE if the lanes are set up successfully, otherwise c_FALSE
+ * @note  Higher lanes have higher priority, Rb_WriteToBuffer writes to lane 0. Each extra lane takes a free
+ *        buffer handle slot and copies the codec, integrity, time stamp, publication, prefetch, wrap and
+ *        watermark settings of the buffer. Sequence, replay, time seek and free space APIs address lane 0. Lanes
+ *        can only be changed while all of them are empty.
  */
-static cU64_t getOccupiedSpace(cI32_t bufferHandle)
+cBool Rb_SetLanes(cI32_t bufferHandle, cU32_t laneCnt, cU64_t laneSizeInBytes, Rb_LanePolicy_e lanePolicy)
 {
-    Rb_Info_t *rbInfo = &gRbInfo[bufferHandle];
+    cU32_t laneId;
 
-    return (rbInfo->size - getFreeSpace(bufferHandle));
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((laneCnt == 0) || (laneCnt > MAX_LANES))
+    {
+        EPRINT("invalid lane count: [laneCnt=%u], [maxLanes=%d]", laneCnt, MAX_LANES);
+        return c_FALSE;
+    }
+
+    if ((lanePolicy != Rb_LanePolicy_STRICT) && (lanePolicy != Rb_LanePolicy_WEIGHTED))
+    {
+        EPRINT("invalid lane policy: [lanePolicy=%d]", lanePolicy);
+        return c_FALSE;
+    }
+
+    if ((laneCnt > 1) && (laneSizeInBytes == 0))
+    {
+        EPRINT("invalid lane size: [laneSizeInBytes=%lu]", laneSizeInBytes);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if ((getTotalUnreadIndexCount(bufferHandle) != 0) || (rbInfo->peekLane->readCommittedF == c_FALSE))
+    {
+        EPRINT("lanes can only be changed on empty buffer: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    for (laneId = 1; laneId < rbInfo->laneCnt; laneId++)
+    {
+        releaseBufferSlot(rbInfo->laneHandle[laneId]);
+    }
+
+    rbInfo->laneCnt = 1;
+    rbInfo->peekLane = rbInfo;
+    rbInfo->lanePolicy = lanePolicy;
+    rbInfo->laneWeight[0] = DEFAULT_SCHED_WEIGHT;
+    rbInfo->laneCredit[0] = DEFAULT_SCHED_WEIGHT;
+
+    for (laneId = 1; laneId < laneCnt; laneId++)
+    {
+        cI32_t laneHandle;
+
+        if (Rb_CtxCreateBuffer(GET_CONTEXT(bufferHandle), laneSizeInBytes, &rbInfo->allocator,
+                               &laneHandle) == c_FALSE)
+        {
+            EPRINT("failed to create lane: [bufferHandle=%d], [laneId=%u]", bufferHandle, laneId);
+            Rb_SetLanes(bufferHandle, 1, 0, lanePolicy);
+            return c_FALSE;
+        }
+
+        Rb_Info_t *laneInfo = &RB_INFO(laneHandle);
+
+        laneInfo->ownerHandle = bufferHandle;
+        laneInfo->codec = rbInfo->codec;
+        laneInfo->integrityMode = rbInfo->integrityMode;
+        laneInfo->timeStampF = rbInfo->timeStampF;
+        laneInfo->publishRecords = rbInfo->publishRecords;
+        laneInfo->publishBytes = rbInfo->publishBytes;
+        laneInfo->releaseRecords = rbInfo->releaseRecords;
+        laneInfo->prefetchDepth = rbInfo->prefetchDepth;
+        laneInfo->wrapPolicy = rbInfo->wrapPolicy;
+        laneInfo->compactOnEmptyF = rbInfo->compactOnEmptyF;
+        laneInfo->highWatermark = rbInfo->highWatermark;
+        applyRateLimit(laneInfo, (rbInfo->rateLimitF == c_TRUE) ? &rbInfo->rateLimit : NULL);
+
+        rbInfo->laneHandle[laneId] = laneHandle;
+        rbInfo->laneWeight[laneId] = DEFAULT_SCHED_WEIGHT;
+        rbInfo->laneCredit[laneId] = DEFAULT_SCHED_WEIGHT;
+        rbInfo->laneCnt++;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the weight of a lane used by Rb_LanePolicy_WEIGHTED.
+ * @param bufferHandle Handle of the buffer.
+ * @param laneId Lane of the buffer.
+ * @param weight Number of picks the lane gets per round while it holds data.
+ * @return cBool Returns c_TRUE if the weight is set successfully, otherwise c_FALSE
+ */
+cBool Rb_SetLaneWeight(cI32_t bufferHandle, cU32_t laneId, cU32_t weight)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((laneId >= RB_INFO(bufferHandle).laneCnt) || (weight == 0))
+    {
+        EPRINT("invalid lane or weight: [laneId=%u], [weight=%u]", laneId, weight);
+        return c_FALSE;
+    }
+
+    RB_INFO(bufferHandle).laneWeight[laneId] = weight;
+    RB_INFO(bufferHandle).laneCredit[laneId] = weight;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Write data to a priority lane of the buffer.
+ * @param bufferHandle Handle of the buffer to write to.
+ * @param laneId Lane to write to, lane 0 is the same as Rb_WriteToBuffer.
+ * @param data Pointer to the data to write.
+ * @param dataBytes Size of the data in bytes.
+ * @return cBool Returns c_TRUE if the data is written successfully, otherwise c_FALSE.
+ */
+cBool Rb_WriteToLane(cI32_t bufferHandle, cU32_t laneId, const cU8_t *data, cU64_t dataBytes)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (laneId >= RB_INFO(bufferHandle).laneCnt)
+    {
+        EPRINT("invalid lane: [laneId=%u], [laneCnt=%u]", laneId, RB_INFO(bufferHandle).laneCnt);
+        return c_FALSE;
+    }
+
+    if ((dataBytes == 0) || (data == NULL))
+    {
+        EPRINT("invalid data or data size: [dataBytes=%lu]", dataBytes);
+        return c_FALSE;
+    }
+
+    return writeRecord(&RB_INFO(RB_INFO(bufferHandle).laneHandle[laneId]), data, dataBytes, 0, 0);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the occupancy watermarks used to signal backpressure to producers.
+ * @param bufferHandle Handle of the buffer.
+ * @param highBytes Unread bytes at or above which backpressure is raised, 0 to disable watermarks.
+ * @param lowBytes Unread bytes at or below which backpressure is cleared, must be below highBytes.
+ * @param callback Callback invoked on each crossing, NULL to only poll with Rb_IsAboveHighWatermark.
+ * @param userData User data passed to the callback.
+ * @return cBool Returns c_TRUE if the watermarks are set successfully, otherwise c_FALSE
+ * @note  The gap between the watermarks is the hysteresis: after the high crossing nothing fires until the
+ *        occupancy falls to the low watermark, so the callback does not flap around a single level. The
+ *        callback runs inside the write, commit or seek call that crossed the watermark. With priority lanes
+ *        the occupancy is the sum over all lanes, one state and callback cover the whole buffer, so set the
+ *        lanes first for highBytes to be checked against their total size.
+ */
+cBool Rb_SetWatermarks(cI32_t bufferHandle, cU64_t highBytes, cU64_t lowBytes, Rb_WatermarkCb_t callback, void *userData)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+    cU64_t     totalSize = 0;
+    cU32_t     laneId;
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        totalSize += RB_INFO(rbInfo->laneHandle[laneId]).size;
+    }
+
+    if ((highBytes != 0) && ((lowBytes >= highBytes) || (highBytes > totalSize)))
+    {
+        EPRINT("invalid watermarks: [highBytes=%lu], [lowBytes=%lu], [size=%lu]", highBytes, lowBytes, totalSize);
+        return c_FALSE;
+    }
+
+    // Every lane sees the high watermark so its writes and commits check the buffer, the state stays on lane 0
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        RB_INFO(rbInfo->laneHandle[laneId]).highWatermark = highBytes;
+    }
+
+    rbInfo->lowWatermark = lowBytes;
+    rbInfo->watermarkCb = callback;
+    rbInfo->watermarkUserData = userData;
+    __atomic_store_n(&rbInfo->aboveHighF, c_FALSE, __ATOMIC_RELEASE);
+
+    if (highBytes != 0)
+    {
+        // Buffer may already be above the new high watermark
+        checkWatermarks(rbInfo);
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Poll whether the buffer is in backpressure, i.e. it crossed the high watermark and has not yet
+ *        fallen to the low watermark.
+ * @param bufferHandle Handle of the buffer.
+ * @param aboveF Pointer to store the backpressure flag.
+ * @return cBool Returns c_TRUE if the flag is retrieved successfully, otherwise c_FALSE
+ */
+cBool Rb_IsAboveHighWatermark(cI32_t bufferHandle, cBool *aboveF)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (aboveF == NULL)
+    {
+        EPRINT("invalid flag pointer");
+        return c_FALSE;
+    }
+
+    *aboveF = __atomic_load_n(&RB_INFO(bufferHandle).aboveHighF, __ATOMIC_ACQUIRE);
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Limit the rate at which records are written to a lane of the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @param laneId Lane to limit, 0 for a buffer without lanes. Lanes created later inherit the limit of lane 0.
+ * @param rateLimit Rates and bursts, a rate of 0 does not limit that quantity. NULL removes the limit.
+ * @return cBool Returns c_TRUE if the limit is set successfully, otherwise c_FALSE
+ * @note  Writes over the limit are rejected with status cStatus_RESOURCE_BUSY of the lane, see Rb_GetWriteStatus.
+ *        A record is accepted while tokens are left, so records larger than the burst still pass once the bucket
+ *        is full.
+ *        The limit is checked after the space checks, so a write rejected by a full ring takes no tokens.
+ */
+cBool Rb_SetRateLimit(cI32_t bufferHandle, cU32_t laneId, const Rb_RateLimit_t *rateLimit)
+{
+    Rb_RateLimit_t tRateLimit;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (laneId >= RB_INFO(bufferHandle).laneCnt)
+    {
+        EPRINT("invalid lane: [laneId=%u], [laneCnt=%u]", laneId, RB_INFO(bufferHandle).laneCnt);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *laneInfo = &RB_INFO(RB_INFO(bufferHandle).laneHandle[laneId]);
+
+    if ((rateLimit == NULL) || ((rateLimit->bytesPerSec == 0) && (rateLimit->recordsPerSec == 0)))
+    {
+        applyRateLimit(laneInfo, NULL);
+        return c_TRUE;
+    }
+
+    // Burst defaults to one second worth of the rate
+    tRateLimit = *rateLimit;
+    tRateLimit.burstBytes = (tRateLimit.burstBytes == 0) ? tRateLimit.bytesPerSec : tRateLimit.burstBytes;
+    tRateLimit.burstRecords = (tRateLimit.burstRecords == 0) ? tRateLimit.recordsPerSec : tRateLimit.burstRecords;
+
+    if ((tRateLimit.burstBytes > MAX_RATE_BURST) || (tRateLimit.burstRecords > MAX_RATE_BURST))
+    {
+        EPRINT("invalid rate limit burst: [burstBytes=%lu], [burstRecords=%lu], [max=%llu]", tRateLimit.burstBytes,
+               tRateLimit.burstRecords, MAX_RATE_BURST);
+        return c_FALSE;
+    }
+
+    applyRateLimit(laneInfo, &tRateLimit);
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the result of the last write to a lane of the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @param laneId Lane written to, 0 for a buffer without lanes.
+ * @param status Pointer to store the status: cStatus_RESOURCE_BUSY when throttled by the rate limit,
+ *               cStatus_NO_RESOURCE when the ring had no room, cStatus_SUCCESS if the write was accepted or no
+ *               write was made yet.
+ * @return cBool Returns c_TRUE if the status is retrieved successfully, otherwise c_FALSE
+ * @note  Every write that passes the argument checks sets the status of its lane, so producers writing to
+ *        different lanes do not see each other's rejections.
+ */
+cBool Rb_GetWriteStatus(cI32_t bufferHandle, cU32_t laneId, cStatus_e *status)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (laneId >= RB_INFO(bufferHandle).laneCnt)
+    {
+        EPRINT("invalid lane: [laneId=%u], [laneCnt=%u]", laneId, RB_INFO(bufferHandle).laneCnt);
+        return c_FALSE;
+    }
+
+    if (status == NULL)
+    {
+        EPRINT("invalid status pointer");
+        return c_FALSE;
+    }
+
+    *status = RB_INFO(RB_INFO(bufferHandle).laneHandle[laneId]).writeStatus;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set how often the writer publishes its cursor to the reader.
+ * @param bufferHandle Handle of the buffer.
+ * @param publishRecords Publish after this many written records, 1 publishes every write.
+ * @param publishBytes Publish after this many written bytes, 0 to publish on record count only.
+ * @return cBool Returns c_TRUE if the batch is set successfully, otherwise c_FALSE
+ * @note  Trade-off: larger batches touch the shared cursor less often, but written records stay invisible to
+ *        the reader (no peek, no ready bit) until the batch is complete or Rb_Flush is called. Applies to all
+ *        lanes of the buffer, each lane batches its own records.
+ */
+cBool Rb_SetPublishBatch(cI32_t bufferHandle, cU32_t publishRecords, cU64_t publishBytes)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (publishRecords == 0)
+    {
+        EPRINT("invalid publish batch: [publishRecords=%u]", publishRecords);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        RB_INFO(rbInfo->laneHandle[laneId]).publishRecords = publishRecords;
+        RB_INFO(rbInfo->laneHandle[laneId]).publishBytes = publishBytes;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set how often the reader releases the space of consumed records to the writer.
+ * @param bufferHandle Handle of the buffer.
+ * @param releaseRecords Release after this many committed records, 1 releases on every commit.
+ * @return cBool Returns c_TRUE if the batch is set successfully, otherwise c_FALSE
+ * @note  Trade-off: larger batches touch the shared cursor less often, but the writer sees up to
+ *        releaseRecords - 1 consumed records as still occupied and may report the buffer full earlier. Applies
+ *        to all lanes of the buffer.
+ */
+cBool Rb_SetReleaseBatch(cI32_t bufferHandle, cU32_t releaseRecords)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (releaseRecords == 0)
+    {
+        EPRINT("invalid release batch: [releaseRecords=%u]", releaseRecords);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        RB_INFO(rbInfo->laneHandle[laneId]).releaseRecords = releaseRecords;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Publish all pending writes and release the space of all consumed records immediately.
+ * @param bufferHandle Handle of the buffer.
+ * @return cBool Returns c_TRUE if the buffer is flushed successfully, otherwise c_FALSE
+ * @note  Flushes every lane of the buffer. Records of an open write group stay unpublished.
+ */
+cBool Rb_Flush(cI32_t bufferHandle)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        Rb_Info_t *laneInfo = &RB_INFO(rbInfo->laneHandle[laneId]);
+
+        // Records of an open write group become visible only when the group is published
+        if ((laneInfo->pendingRecords != 0) && (laneInfo->groupOpenF == c_FALSE))
+        {
+            publishWrites(laneInfo);
+        }
+
+        if (laneInfo->releasePending != 0)
+        {
+            // Complete the release batch
+            laneInfo->releasePending = laneInfo->releaseRecords;
+            consumeRecords(laneInfo, 0);
+        }
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Open a write group. Records written until the group is published become visible to the reader
+ *        together, with one cursor publication.
+ * @param bufferHandle Handle of the buffer.
+ * @return cBool Returns c_TRUE if the group is opened successfully, otherwise c_FALSE
+ * @note  Rb_WriteToBuffer and Rb_AppendToWriteGroup both add to an open group. Records written to other
+ *        lanes with Rb_WriteToLane are not part of the group.
+ */
+cBool Rb_BeginWriteGroup(cI32_t bufferHandle)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if (rbInfo->groupOpenF == c_TRUE)
+    {
+        EPRINT("write group already open: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    rbInfo->groupOpenF = c_TRUE;
+    markGroupStart(rbInfo);
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Write a record to the open write group.
+ * @param bufferHandle Handle of the buffer.
+ * @param data Pointer to the data to write.
+ * @param dataBytes Size of the data in bytes.
+ * @return cBool Returns c_TRUE if the record is written successfully, otherwise c_FALSE. The group stays open
+ *         on failure, so the caller decides between publishing the records written so far and aborting.
+ */
+cBool Rb_AppendToWriteGroup(cI32_t bufferHandle, const cU8_t *data, cU64_t dataBytes)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (RB_INFO(bufferHandle).groupOpenF == c_FALSE)
+    {
+        EPRINT("no write group open: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((data == NULL) || (dataBytes == 0))
+    {
+        EPRINT("invalid data or data size: [dataBytes=%lu]", dataBytes);
+        return c_FALSE;
+    }
+
+    return writeRecord(&RB_INFO(bufferHandle), data, dataBytes, 0, 0);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Close the write group and make all of its records visible to the reader at once.
+ * @param bufferHandle Handle of the buffer.
+ * @return cBool Returns c_TRUE if the group is published successfully, otherwise c_FALSE
+ * @note  Records written before the group and held back by the publish batch are published too.
+ */
+cBool Rb_PublishWriteGroup(cI32_t bufferHandle)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if (rbInfo->groupOpenF == c_FALSE)
+    {
+        EPRINT("no write group open: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    rbInfo->groupOpenF = c_FALSE;
+    if (rbInfo->pendingRecords != 0)
+    {
+        publishWrites(rbInfo);
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Close the write group and drop all of its records. The writer returns to where the group was opened,
+ *        the records were never visible to the reader.
+ * @param bufferHandle Handle of the buffer.
+ * @return cBool Returns c_TRUE if the group is aborted successfully, otherwise c_FALSE
+ * @note  Retained records reclaimed to make space for the group are not restored.
+ */
+cBool Rb_AbortWriteGroup(cI32_t bufferHandle)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if (rbInfo->groupOpenF == c_FALSE)
+    {
+        EPRINT("no write group open: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    // Index entries past the write index are never read, so rolling back the cursors drops the records
+    rbInfo->groupOpenF = c_FALSE;
+    rbInfo->writeIndex = rbInfo->groupWriteIndex;
+    rbInfo->writeOffset = rbInfo->groupWriteOffset;
+    rbInfo->nextSeq = rbInfo->groupSeq;
+    rbInfo->pendingRecords = rbInfo->groupPendingRecords;
+    rbInfo->pendingBytes = rbInfo->groupPendingBytes;
+
+    // Only the counters of the dropped records, rejects and reads during the group stay counted
+    rbInfo->stats.fragmentedRecords = rbInfo->groupFragmentedRecords;
+    rbInfo->stats.paddedRecords = rbInfo->groupPaddedRecords;
+    rbInfo->stats.paddingBytes = rbInfo->groupPaddingBytes;
+
+    if (rbInfo->highWatermark != 0)
+    {
+        checkWatermarks(rbInfo);
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set how many records ahead of the reader are prefetched by peek read.
+ * @param bufferHandle Handle of the buffer.
+ * @param prefetchDepth Distance in records of the prefetched record, 0 to disable prefetching.
+ * @return cBool Returns c_TRUE if the depth is set successfully, otherwise c_FALSE
+ * @note  Every peek prefetches the index entry and the first cache lines of the record prefetchDepth records
+ *        ahead. Prefetching is off by default and opt-in: the rb_bench_perf sweep shows no gain over the
+ *        hardware prefetcher on the sequential read path (at 4 KB, depth 8 was slower than depth 0), so only
+ *        enable it after measuring the consumer it is meant for. Applies to all lanes of the buffer.
+ */
+cBool Rb_SetPrefetchDepth(cI32_t bufferHandle, cU32_t prefetchDepth)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (prefetchDepth > MAX_PREFETCH_DEPTH)
+    {
+        EPRINT("invalid prefetch depth: [prefetchDepth=%u], [maxDepth=%d]", prefetchDepth, MAX_PREFETCH_DEPTH);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        RB_INFO(rbInfo->laneHandle[laneId]).prefetchDepth = prefetchDepth;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the codec applied to records written to the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @param codec Record codec.
+ * @return cBool Returns c_TRUE if the codec is set successfully, otherwise c_FALSE
+ * @note  Records are flagged individually, so the codec can be changed at any time. Peek reads decode into the
+ *        reassembly or replay memory, Rb_ReadToBuffer decodes straight into the user memory. Applies to all lanes
+ *        of the buffer.
+ */
+cBool Rb_SetCodec(cI32_t bufferHandle, Rb_Codec_e codec)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((codec != Rb_Codec_NONE) && (codec != Rb_Codec_LZ))
+    {
+        EPRINT("invalid codec: [codec=%d]", codec);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        RB_INFO(rbInfo->laneHandle[laneId]).codec = codec;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Peek the record with the given sequence number without consuming anything.
+ * @param bufferHandle Handle of the buffer.
+ * @param sequence Sequence number of the record, unread or still retained.
+ * @param readPtr Pointer to store the record pointer.
+ * @param dataBytes Pointer to store the size of the record in bytes.
+ * @return cBool Returns c_TRUE if the record is found, otherwise c_FALSE
+ * @note  The record is located through the sequence index in O(1). The returned pointer stays valid until the
+ *        record is reclaimed or the next Rb_PeekAt call on the buffer. Compressed records are decoded into the
+ *        replay memory.
+ */
+cBool Rb_PeekAt(cI32_t bufferHandle, cU64_t sequence, cU8_t **readPtr, cU64_t *dataBytes)
+{
+    cU64_t dataIndex, nextIndex;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((readPtr == NULL) || (dataBytes == NULL))
+    {
+        EPRINT("invalid data pointer");
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if ((sequence < rbInfo->oldestSeq) || (sequence >= rbInfo->pubSeq))
+    {
+        EPRINT("sequence not available: [sequence=%lu], [oldestSeq=%lu], [nextSeq=%lu]", sequence, rbInfo->oldestSeq,
+               rbInfo->pubSeq);
+        return c_FALSE;
+    }
+
+    dataIndex = rbInfo->seqIndex[sequence % MAX_DATA_INDEX];
+
+    if (rbInfo->entry[dataIndex].flags & RECORD_FLAG_COMPRESSED)
+    {
+        if (growScratch(rbInfo, &rbInfo->replayBuf, &rbInfo->replayBufSize, getDecodeScratchBytes(rbInfo, dataIndex)) ==
+            c_FALSE)
+        {
+            EPRINT("failed to allocate memory for decoding compressed data: [sequence=%lu]", sequence);
+            return c_FALSE;
+        }
+
+        *dataBytes = decodeRecord(rbInfo, dataIndex, rbInfo->replayBuf);
+        *readPtr = rbInfo->replayBuf;
+        return (*dataBytes != 0) ? c_TRUE : c_FALSE;
+    }
+
+    if ((rbInfo->entry[dataIndex].flags & RECORD_FLAG_FRAGMENTED) == 0)
+    {
+        *readPtr = rbInfo->pBufferBegin + rbInfo->entry[dataIndex].dataOffset;
+        *dataBytes = rbInfo->entry[dataIndex].dataLen;
+        return c_TRUE;
+    }
+
+    nextIndex = (dataIndex + 1) % MAX_DATA_INDEX;
+    *dataBytes = rbInfo->entry[dataIndex].dataLen + rbInfo->entry[nextIndex].dataLen;
+
+    if (growScratch(rbInfo, &rbInfo->replayBuf, &rbInfo->replayBufSize, *dataBytes) == c_FALSE)
+    {
+        EPRINT("failed to allocate memory for reading fragmented data: [dataBytes=%lu]", *dataBytes);
+        return c_FALSE;
+    }
+
+    memcpy(rbInfo->replayBuf, rbInfo->pBufferBegin + rbInfo->entry[dataIndex].dataOffset, rbInfo->entry[dataIndex].dataLen);
+    memcpy(rbInfo->replayBuf + rbInfo->entry[dataIndex].dataLen, rbInfo->pBufferBegin, rbInfo->entry[nextIndex].dataLen);
+    *readPtr = rbInfo->replayBuf;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the sequence number of the record returned by the last peek read.
+ * @param bufferHandle Handle of the buffer.
+ * @param sequence Pointer to store the sequence number.
+ * @return cBool Returns c_TRUE if the sequence number is retrieved successfully, otherwise c_FALSE
+ */
+cBool Rb_GetPeekSequence(cI32_t bufferHandle, cU64_t *sequence)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (sequence == NULL)
+    {
+        EPRINT("invalid sequence pointer");
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = RB_INFO(bufferHandle).peekLane;
+
+    if (rbInfo->readCommittedF == c_TRUE)
+    {
+        EPRINT("no peek read has been performed");
+        return c_FALSE;
+    }
+
+    *sequence = rbInfo->peekSeq;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the range of sequence numbers that can be peeked with Rb_PeekAt.
+ * @param bufferHandle Handle of the buffer.
+ * @param oldestSeq Pointer to store the sequence number of the oldest retained or unread record.
+ * @param nextSeq Pointer to store the sequence number the next published record will get.
+ * @return cBool Returns c_TRUE if the range is retrieved successfully, otherwise c_FALSE
+ */
+cBool Rb_GetSequenceRange(cI32_t bufferHandle, cU64_t *oldestSeq, cU64_t *nextSeq)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((oldestSeq == NULL) || (nextSeq == NULL))
+    {
+        EPRINT("invalid sequence pointer");
+        return c_FALSE;
+    }
+
+    *oldestSeq = RB_INFO(bufferHandle).oldestSeq;
+    *nextSeq = RB_INFO(bufferHandle).pubSeq;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set how many consumed records are kept for replay with Rb_PeekAt.
+ * @param bufferHandle Handle of the buffer.
+ * @param retainRecords Number of most recently consumed records to keep.
+ * @return cBool Returns c_TRUE if the retention is set successfully, otherwise c_FALSE
+ * @note  Retention is best effort: when the writer runs out of space or indices it reclaims the oldest
+ *        retained records instead of failing. Applies to lane 0 only, the lane Rb_PeekAt replays from.
+ */
+cBool Rb_SetRetention(cI32_t bufferHandle, cU64_t retainRecords)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    rbInfo->retainRecords = retainRecords;
+    consumeRecords(rbInfo, 0);
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Enable or disable stamping records with their write time.
+ * @param bufferHandle Handle of the buffer.
+ * @param timeStampF c_TRUE to stamp records on write, c_FALSE otherwise.
+ * @return cBool Returns c_TRUE if the setting is applied successfully, otherwise c_FALSE
+ * @note  Applies to all lanes and can only be changed while every lane is empty, so that unread records are
+ *        always ordered by time. Cannot be disabled while a time to live is set, as expiry reads the stamps.
+ */
+cBool Rb_SetTimeStamping(cI32_t bufferHandle, cBool timeStampF)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (IS_VALID_BOOL(timeStampF) == c_FALSE)
+    {
+        EPRINT("invalid time stamp flag: [timeStampF=%d]", timeStampF);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if ((timeStampF == c_FALSE) && (rbInfo->ttlNs != 0))
+    {
+        EPRINT("time stamping needed by time to live: [bufferHandle=%d], [ttlNs=%lu]", bufferHandle, rbInfo->ttlNs);
+        return c_FALSE;
+    }
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        if ((getUnreadIndexCount(&RB_INFO(rbInfo->laneHandle[laneId])) != 0) ||
+            (RB_INFO(rbInfo->laneHandle[laneId]).pendingRecords != 0))
+        {
+            EPRINT("time stamping can only be changed on empty buffer: [bufferHandle=%d], [laneId=%u]", bufferHandle,
+                   laneId);
+            return c_FALSE;
+        }
+    }
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        RB_INFO(rbInfo->laneHandle[laneId]).timeStampF = timeStampF;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the current time of the clock used to stamp records.
+ * @return cU64_t Returns the monotonic time in nanoseconds.
+ */
+cU64_t Rb_GetTimeNs(void)
+{
+    return Utils_GetMonotonicTimeNs();
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the write time of the record returned by the last peek read.
+ * @param bufferHandle Handle of the buffer.
+ * @param timeStampNs Pointer to store the write time in nanoseconds.
+ * @return cBool Returns c_TRUE if the time is retrieved successfully, otherwise c_FALSE
+ */
+cBool Rb_GetPeekTimeStamp(cI32_t bufferHandle, cU64_t *timeStampNs)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (timeStampNs == NULL)
+    {
+        EPRINT("invalid time stamp pointer");
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = RB_INFO(bufferHandle).peekLane;
+
+    if ((rbInfo->timeStampF == c_FALSE) || (rbInfo->readCommittedF == c_TRUE))
+    {
+        EPRINT("no time stamped peek read has been performed: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    *timeStampNs = rbInfo->peekTimeStamp;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Move the reader to the first record written at or after the given time, dropping older records.
+ * @param bufferHandle Handle of the buffer.
+ * @param timeStampNs Time in nanoseconds, as returned by Rb_GetTimeNs.
+ * @return cBool Returns c_TRUE if the reader is moved successfully, otherwise c_FALSE
+ * @note  Unread records are ordered by time, so the target is found by binary search over the index and the
+ *        dropped records are never touched. Every lane is searched on its own, none may have a peek outstanding.
+ */
+cBool Rb_SeekToTime(cI32_t bufferHandle, cU64_t timeStampNs)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    if (rbInfo->timeStampF == c_FALSE)
+    {
+        EPRINT("time stamping is disabled: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        if (RB_INFO(rbInfo->laneHandle[laneId]).readCommittedF == c_FALSE)
+        {
+            EPRINT("previous read not committed: [bufferHandle=%d], [laneId=%u]", bufferHandle, laneId);
+            return c_FALSE;
+        }
+    }
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        seekLaneToTime(&RB_INFO(rbInfo->laneHandle[laneId]), timeStampNs);
+    }
+
+    // Occupancy is summed over the lanes, so the watermarks and the ready bit are updated once for all of them
+    if (rbInfo->highWatermark != 0)
+    {
+        checkWatermarks(rbInfo);
+    }
+
+    if (getTotalUnreadIndexCount(bufferHandle) == 0)
+    {
+        clearBufferReady(bufferHandle);
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the age after which unread records of the buffer and its lanes expire.
+ * @param bufferHandle Handle of the buffer.
+ * @param ttlNs Time to live in nanoseconds from the write time stamp, 0 to keep records until read.
+ * @return cBool Returns c_TRUE if the time to live is set successfully, otherwise c_FALSE
+ * @note  Expiry is lazy: peek and copy reads consume the expired records ahead of the reader in one pass over
+ *        the index and count them in expiredRecords of Rb_Stats_t. Requires time stamping, which cannot be
+ *        disabled until the time to live is set back to 0.
+ */
+cBool Rb_SetTimeToLive(cI32_t bufferHandle, cU64_t ttlNs)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((ttlNs != 0) && (RB_INFO(bufferHandle).timeStampF == c_FALSE))
+    {
+        EPRINT("time to live needs time stamping: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    RB_INFO(bufferHandle).ttlNs = ttlNs;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set when the per-record checksum of the buffer is verified.
+ * @param bufferHandle Handle of the buffer.
+ * @param integrityMode Integrity checking mode.
+ * @return cBool Returns c_TRUE if the mode is set successfully, otherwise c_FALSE
+ * @note  The mode applies to all lanes and can only be changed while every lane is empty, so that every unread
+ *        record carries a checksum when checking is enabled.
+ */
+cBool Rb_SetIntegrityMode(cI32_t bufferHandle, Rb_IntegrityMode_e integrityMode)
+{
+    cU32_t laneId;
+
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if ((integrityMode != Rb_IntegrityMode_NONE) && (integrityMode != Rb_IntegrityMode_VERIFY_ON_PEEK) &&
+        (integrityMode != Rb_IntegrityMode_VERIFY_ON_DEMAND))
+    {
+        EPRINT("invalid integrity mode: [integrityMode=%d]", integrityMode);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        if ((getUnreadIndexCount(&RB_INFO(rbInfo->laneHandle[laneId])) != 0) ||
+            (RB_INFO(rbInfo->laneHandle[laneId]).pendingRecords != 0))
+        {
+            EPRINT("integrity mode can only be changed on empty buffer: [bufferHandle=%d], [laneId=%u]", bufferHandle,
+                   laneId);
+            return c_FALSE;
+        }
+    }
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        RB_INFO(rbInfo->laneHandle[laneId]).integrityMode = integrityMode;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Verify the checksum of the peeked data, used with Rb_IntegrityMode_VERIFY_ON_DEMAND.
+ * @param bufferHandle Handle of the buffer.
+ * @param readPtr Pointer returned by the last peek read.
+ * @param dataBytes Size returned by the last peek read.
+ * @return cBool Returns c_TRUE if the data matches the checksum computed at write, otherwise c_FALSE
+ */
+cBool Rb_VerifyRead(cI32_t bufferHandle, const cU8_t *readPtr, cU64_t dataBytes)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (readPtr == NULL)
+    {
+        EPRINT("invalid data pointer");
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = RB_INFO(bufferHandle).peekLane;
+
+    if (rbInfo->integrityMode == Rb_IntegrityMode_NONE)
+    {
+        EPRINT("integrity checking is disabled: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (rbInfo->readCommittedF == c_TRUE)
+    {
+        EPRINT("no peek read has been performed");
+        return c_FALSE;
+    }
+
+    return verifyPeekedData(rbInfo, readPtr, dataBytes);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check the cursors and the record index of the buffer and all of its lanes against each other.
+ * @param bufferHandle Handle of the buffer.
+ * @return cBool Returns c_TRUE if the buffer state is consistent, otherwise c_FALSE with the first violation
+ *         printed.
+ * @note  Walks every index in use, meant for stress and soak harnesses calling it between operations, not for
+ *        the data path.
+ */
+cBool Rb_CheckConsistency(cI32_t bufferHandle)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+    cU32_t     laneId;
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        if (checkSlotConsistency(&RB_INFO(rbInfo->laneHandle[laneId])) == c_FALSE)
+        {
+            EPRINT("inconsistent buffer state: [bufferHandle=%d], [laneId=%u]", bufferHandle, laneId);
+            return c_FALSE;
+        }
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Select the policy used by Rb_GetNextReadyBuffer.
+ * @param policy Scheduling policy.
+ * @return cBool Returns c_TRUE if the policy is set successfully, otherwise c_FALSE
+ */
+cBool Rb_SetSchedPolicy(Rb_SchedPolicy_e policy)
+{
+    return Rb_CtxSetSchedPolicy(&gRbDefaultContext, policy);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Select the policy used by Rb_CtxGetNextReadyBuffer for the buffers of the context.
+ * @param context Context to set the policy of.
+ * @param policy Scheduling policy.
+ * @return cBool Returns c_TRUE if the policy is set successfully, otherwise c_FALSE
+ */
+cBool Rb_CtxSetSchedPolicy(Rb_Context_t *context, Rb_SchedPolicy_e policy)
+{
+    if (context == NULL)
+    {
+        EPRINT("invalid context");
+        return c_FALSE;
+    }
+
+    if ((policy != Rb_SchedPolicy_ROUND_ROBIN) && (policy != Rb_SchedPolicy_WEIGHTED_FAIR))
+    {
+        EPRINT("invalid scheduling policy: [policy=%d]", policy);
+        return c_FALSE;
+    }
+
+    context->sched.policy = policy;
+    context->sched.credit = 0;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the weighted-fair scheduling weight of the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @param weight Number of consecutive picks the buffer gets while it stays ready.
+ * @return cBool Returns c_TRUE if the weight is set successfully, otherwise c_FALSE
+ */
+cBool Rb_SetSchedWeight(cI32_t bufferHandle, cU32_t weight)
+{
+    if (IS_VALID_BUFFER_HANDLE(bufferHandle) == c_FALSE)
+    {
+        EPRINT("invalid buffer handle: [bufferHandle=%d]", bufferHandle);
+        return c_FALSE;
+    }
+
+    if (weight == 0)
+    {
+        EPRINT("invalid scheduling weight: [weight=%u]", weight);
+        return c_FALSE;
+    }
+
+    RB_INFO(bufferHandle).schedWeight = weight;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the handles of all buffers holding unread data.
+ * @param bufferHandles Array to store the ready handles in ascending order.
+ * @param maxHandles Capacity of the handle array.
+ * @return cU32_t Returns the number of handles stored in the array.
+ */
+cU32_t Rb_GetReadyBuffers(cI32_t *bufferHandles, cU32_t maxHandles)
+{
+    return Rb_CtxGetReadyBuffers(&gRbDefaultContext, bufferHandles, maxHandles);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the handles of all buffers of the context holding unread data.
+ * @param context Context to scan.
+ * @param bufferHandles Array to store the ready handles in ascending order.
+ * @param maxHandles Capacity of the handle array.
+ * @return cU32_t Returns the number of handles stored in the array.
+ */
+cU32_t Rb_CtxGetReadyBuffers(Rb_Context_t *context, cI32_t *bufferHandles, cU32_t maxHandles)
+{
+    cU32_t handleCnt = 0;
+    cU32_t wordId;
+
+    if ((context == NULL) || (bufferHandles == NULL))
+    {
+        EPRINT("invalid buffer handle array");
+        return 0;
+    }
+
+    for (wordId = 0; wordId < READY_MAP_WORDS; wordId++)
+    {
+        cU64_t readyBits = __atomic_load_n(&context->readyMap[wordId], __ATOMIC_ACQUIRE);
+
+        while ((readyBits != 0) && (handleCnt < maxHandles))
+        {
+            cI32_t slotId = (cI32_t)((wordId * READY_MAP_WORD_BITS) + __builtin_ctzll(readyBits));
+
+            bufferHandles[handleCnt++] = MAKE_BUFFER_HANDLE(context->contextId, slotId);
+            readyBits &= (readyBits - 1);
+        }
+    }
+
+    return handleCnt;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Pick the next buffer holding unread data according to the scheduling policy.
+ * @param bufferHandle Pointer to store the handle of the picked buffer.
+ * @return cBool Returns c_TRUE if a ready buffer is found, otherwise c_FALSE
+ * @note  Round-robin moves to the next ready handle on every call. Weighted-fair keeps returning the same
+ *        handle for up to its weight consecutive calls while it stays ready, then moves on, so a hot buffer
+ *        can never starve the others.
+ */
+cBool Rb_GetNextReadyBuffer(cI32_t *bufferHandle)
+{
+    return Rb_CtxGetNextReadyBuffer(&gRbDefaultContext, bufferHandle);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Pick the next buffer of the context holding unread data according to its scheduling policy.
+ * @param context Context to pick from.
+ * @param bufferHandle Pointer to store the handle of the picked buffer.
+ * @return cBool Returns c_TRUE if a ready buffer is found, otherwise c_FALSE
+ */
+cBool Rb_CtxGetNextReadyBuffer(Rb_Context_t *context, cI32_t *bufferHandle)
+{
+    Rb_SchedInfo_t *sched;
+    cI32_t          readySlotId;
+
+    if ((context == NULL) || (bufferHandle == NULL))
+    {
+        EPRINT("invalid context or buffer handle pointer");
+        return c_FALSE;
+    }
+
+    sched = &context->sched;
+    if ((sched->policy == Rb_SchedPolicy_WEIGHTED_FAIR) && (sched->credit > 0) &&
+        (findReadyHandle(context, sched->lastSlotId) == sched->lastSlotId))
+    {
+        sched->credit--;
+        *bufferHandle = MAKE_BUFFER_HANDLE(context->contextId, sched->lastSlotId);
+        return c_TRUE;
+    }
+
+    readySlotId = findReadyHandle(context, sched->lastSlotId + 1);
+    if (readySlotId == INVALID_BUFFER_HANDLE)
+    {
+        sched->credit = 0;
+        return c_FALSE;
+    }
+
+    sched->lastSlotId = readySlotId;
+    sched->credit = context->rbInfo[readySlotId].schedWeight - 1;
+    *bufferHandle = MAKE_BUFFER_HANDLE(context->contextId, readySlotId);
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Write a record to the buffer or lane.
+ * @param rbInfo Pointer to the ring buffer information of the buffer or hidden lane.
+ * @param data Pointer to the data to write.
+ * @param dataBytes Size of the data in bytes.
+ * @param tag Tag of the record.
+ * @param userWord User word of the record.
+ * @return cBool Returns c_TRUE if the data is written successfully, otherwise c_FALSE.
+ */
+static cBool writeRecord(Rb_Info_t *rbInfo, const cU8_t *data, cU64_t dataBytes, cU8_t tag, cU32_t userWord)
+{
+    cU64_t           contiguousFreeSpace;
+    cU64_t           rawBytes = dataBytes;
+    cU64_t           timeStampNs = 0;
+    cU8_t            recordFlags = 0;
+    const cU8_t     *tDataPtr = data;
+    Rb_IndexEntry_t *pEntry;
+
+    rbInfo->writeStatus = cStatus_SUCCESS;
+
+    // Raw length is kept in 32 bits like the stored one, larger records are stored raw and rejected if too big
+    if ((rbInfo->codec == Rb_Codec_LZ) && (dataBytes >= MIN_COMPRESS_BYTES) && (dataBytes <= UINT32_MAX))
+    {
+        // Incompressible records are stored raw
+        if (encodeRecord(rbInfo, data, rawBytes, &dataBytes) == c_TRUE)
+        {
+            tDataPtr = rbInfo->codecBuf;
+            recordFlags |= RECORD_FLAG_COMPRESSED;
+        }
+    }
+
+    if ((rbInfo->compactOnEmptyF == c_TRUE) && IS_BUFFER_EMPTY(rbInfo) && (RING_POS(rbInfo, rbInfo->writeOffset) != 0))
+    {
+        // Start over at the beginning so the next records share warm cache lines
+        compactWriter(rbInfo);
+    }
+
+    // Reclaim released retained records the writer needs, a fragmented record takes two indices
+    while ((rbInfo->retainCount > rbInfo->releasePending) &&
+           ((getUsedIndexCount(rbInfo) >= (MAX_DATA_INDEX - 2)) || (isSpaceForRecord(rbInfo, dataBytes) == c_FALSE)))
+    {
+        dropOldestRetained(rbInfo);
+    }
+
+    if (getUsedIndexCount(rbInfo) >= (MAX_DATA_INDEX - 2))
+    {
+        EPRINT("max data index reached");
+        TRACE_PROBE3(ringbuffer, write_reject, rbInfo->bufferHandle, rawBytes, getOccupiedSpace(rbInfo));
+        rbInfo->writeStatus = cStatus_NO_RESOURCE;
+        return c_FALSE;
+    }
+
+    if (isSpaceForRecord(rbInfo, dataBytes) == c_FALSE)
+    {
+        EPRINT("not enough free space in buffer: [dataBytes=%lu], [freeSpace=%lu], [contiguousFreeSpace=%lu]", dataBytes,
+               getFreeSpace(rbInfo), getContiguousFreeSpace(rbInfo));
+        TRACE_PROBE3(ringbuffer, write_reject, rbInfo->bufferHandle, rawBytes, getOccupiedSpace(rbInfo));
+        rbInfo->writeStatus = cStatus_NO_RESOURCE;
+        return c_FALSE;
+    }
+
+    // Tokens are only taken by a record that fits, retained records reclaimed for a throttled one stay reclaimed
+    if ((rbInfo->rateLimitF == c_TRUE) && (takeRateTokens(rbInfo, rawBytes) == c_FALSE))
+    {
+        // Throttling is shaping, not an error, so it is counted instead of printed
+        rbInfo->stats.throttledRecords++;
+        TRACE_PROBE3(ringbuffer, write_reject, rbInfo->bufferHandle, rawBytes, getOccupiedSpace(rbInfo));
+        rbInfo->writeStatus = cStatus_RESOURCE_BUSY;
+        return c_FALSE;
+    }
+
+    contiguousFreeSpace = getContiguousFreeSpace(rbInfo);
+    pEntry = &rbInfo->entry[rbInfo->writeIndex];
+
+    if (rbInfo->integrityMode != Rb_IntegrityMode_NONE)
+    {
+        // Checksum is kept at the first index of the record, even if the record gets fragmented, and covers the
+        // record as written so a decoded peek is verified against what the producer passed in
+        pEntry->crc = Crc32c_Compute(data, rawBytes);
+    }
+
+    if (rbInfo->timeStampF == c_TRUE)
+    {
+        timeStampNs = Utils_GetMonotonicTimeNs();
+    }
+
+    pEntry->seq = rbInfo->nextSeq;
+    pEntry->timeStamp = timeStampNs;
+    pEntry->rawLen = (cU32_t)rawBytes;
+    pEntry->flags = recordFlags;
+    pEntry->tag = tag;
+    pEntry->userWord = userWord;
+    rbInfo->seqIndex[rbInfo->nextSeq % MAX_DATA_INDEX] = (cU16_t)rbInfo->writeIndex;
+    rbInfo->nextSeq++;
+
+    if (contiguousFreeSpace < dataBytes)
+    {
+        // Contiguous space is the tail of the lap here, the record continues or starts at the next lap
+        if (rbInfo->wrapPolicy == Rb_WrapPolicy_PAD)
+        {
+            // Tail is left as padding, reader finds the record at the beginning through its index offset
+            rbInfo->stats.paddedRecords++;
+            rbInfo->stats.paddingBytes += contiguousFreeSpace;
+        }
+        else
+        {
+            rbInfo->stats.fragmentedRecords++;
+            pEntry->flags |= RECORD_FLAG_FRAGMENTED;
+            memcpy(RING_PTR(rbInfo, rbInfo->writeOffset), tDataPtr, contiguousFreeSpace);
+            pEntry->dataLen = (cU32_t)contiguousFreeSpace;
+            pEntry->dataOffset = (cU32_t)RING_POS(rbInfo, rbInfo->writeOffset);
+            rbInfo->writeIndex++;
+
+            if (rbInfo->writeIndex == MAX_DATA_INDEX)
+            {
+                // Wrap around
+                rbInfo->writeIndex = 0;
+            }
+
+            // Second part carries the record identity and stamp too, only the first part carries the flags
+            pEntry = &rbInfo->entry[rbInfo->writeIndex];
+            pEntry->seq = rbInfo->nextSeq - 1;
+            pEntry->timeStamp = timeStampNs;
+            pEntry->rawLen = (cU32_t)rawBytes;
+            pEntry->flags = 0;
+            pEntry->tag = tag;
+            pEntry->userWord = userWord;
+
+            // Update pointer and size to write remaining data
+            tDataPtr += contiguousFreeSpace;
+            dataBytes -= contiguousFreeSpace;
+        }
+
+        rbInfo->writeOffset += contiguousFreeSpace;
+    }
+
+    memcpy(RING_PTR(rbInfo, rbInfo->writeOffset), tDataPtr, dataBytes);
+    pEntry->dataLen = (cU32_t)dataBytes;
+    pEntry->dataOffset = (cU32_t)RING_POS(rbInfo, rbInfo->writeOffset);
+    rbInfo->writeIndex++;
+    rbInfo->writeOffset += dataBytes;
+
+    if (rbInfo->writeIndex == MAX_DATA_INDEX)
+    {
+        // Wrap around
+        rbInfo->writeIndex = 0;
+    }
+
+    rbInfo->pendingRecords++;
+    rbInfo->pendingBytes += rawBytes;
+    TRACE_PROBE3(ringbuffer, write, rbInfo->bufferHandle, rawBytes, getOccupiedSpace(rbInfo));
+
+    if ((rbInfo->groupOpenF == c_FALSE) &&
+        ((rbInfo->pendingRecords >= rbInfo->publishRecords) ||
+         ((rbInfo->publishBytes != 0) && (rbInfo->pendingBytes >= rbInfo->publishBytes))))
+    {
+        publishWrites(rbInfo);
+    }
+
+    if (rbInfo->highWatermark != 0)
+    {
+        checkWatermarks(rbInfo);
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Peek the next record of the buffer or lane.
+ * @param rbInfo Pointer to the ring buffer information of the buffer or hidden lane.
+ * @param readPtr Pointer to store the read pointer.
+ * @param dataBytes Pointer to store the size of the read data in bytes.
+ * @param decodeF c_TRUE to decode a compressed record into the reassembly memory, c_FALSE to return the stored
+ *        bytes and leave the decoding and its checksum to the caller.
+ * @return cBool Returns c_TRUE if the data is read successfully, otherwise c_FALSE.
+ */
+static cBool peekRecord(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes, cBool decodeF)
+{
+    cBool storedF;
+
+    const Rb_IndexEntry_t *pEntry;
+
+    if (rbInfo->readCommittedF == c_FALSE)
+    {
+        EPRINT("previous read not committed");
+        return c_FALSE;
+    }
+
+    if (IS_NO_DATA_TO_READ(rbInfo))
+    {
+        // Nothing is peeked, so there is nothing to commit
+        EPRINT("no data available to read");
+        *dataBytes = 0;
+        return c_FALSE;
+    }
+
+    rbInfo->readCommittedF = c_FALSE;
+
+    // Reader follows the index, which also skips the end of the buffer after a wrap, padding or compaction
+    pEntry = &rbInfo->entry[rbInfo->readIndex];
+    rbInfo->readOffset = getRecordOffset(rbInfo, PAST_COMPACTION(rbInfo, rbInfo->readOffset), rbInfo->readIndex);
+    rbInfo->peekCrc = pEntry->crc;
+    rbInfo->peekSeq = pEntry->seq;
+    rbInfo->peekTag = pEntry->tag;
+    rbInfo->peekUserWord = pEntry->userWord;
+
+    rbInfo->peekTimeStamp = pEntry->timeStamp;
+    rbInfo->peekRawLen = pEntry->rawLen;
+
+    if (rbInfo->prefetchDepth != 0)
+    {
+        prefetchRecords(rbInfo);
+    }
+
+    // Stored bytes of a compressed record are returned only to a caller that decodes them itself
+    storedF = (IS_DATA_COMPRESSED(rbInfo) && (decodeF == c_FALSE)) ? c_TRUE : c_FALSE;
+
+    if (IS_DATA_COMPRESSED(rbInfo) && (decodeF == c_TRUE))
+    {
+        if (handleCompressedPeek(rbInfo, readPtr, dataBytes) == c_FALSE)
+        {
+            if (*dataBytes == 0)
+            {
+                // Nothing has been consumed, the peek can be retried
+                rbInfo->readCommittedF = c_TRUE;
+            }
+
+            return c_FALSE;
+        }
+    }
+    else if (IS_DATA_FRAGMENTED(rbInfo))
+    {
+        if (handleFragmentedPeek(rbInfo, readPtr, dataBytes) == c_FALSE)
+        {
+            // Nothing has been consumed, the peek can be retried
+            rbInfo->readCommittedF = c_TRUE;
+            *dataBytes = 0;
+            return c_FALSE;
+        }
+    }
+    else
+    {
+        *readPtr = RING_PTR(rbInfo, rbInfo->readOffset);
+        *dataBytes = pEntry->dataLen;
+    }
+
+    // Probes report the record size as written, a copy read peeks the stored bytes of a compressed record
+    TRACE_PROBE3(ringbuffer, peek, rbInfo->bufferHandle, rbInfo->peekRawLen, getOccupiedSpace(rbInfo));
+
+    if ((rbInfo->integrityMode == Rb_IntegrityMode_VERIFY_ON_PEEK) && (storedF == c_FALSE))
+    {
+        return verifyPeekedData(rbInfo, *readPtr, *dataBytes);
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Commit the peeked record of the buffer or lane.
+ * @param rbInfo Pointer to the ring buffer information of the buffer or hidden lane.
+ * @param dataBytes Size of the data read in bytes.
+ * @return cBool Returns c_TRUE if the read is committed successfully, otherwise c_FALSE
+ */
+static cBool commitRecord(Rb_Info_t *rbInfo, cU64_t dataBytes)
+{
+    if (rbInfo->readCommittedF == c_TRUE)
+    {
+        EPRINT("no peek read has been performed");
+        return c_FALSE;
+    }
+
+    rbInfo->readCommittedF = c_TRUE;
+
+    if (dataBytes == 0)
+    {
+        EPRINT("invalid data size: [dataBytes=%lu]", dataBytes);
+        return c_FALSE;
+    }
+
+    /* Note: If the data was fragmented during write, it was reassembled into the reassembly memory during
+     *       peek read and all pointers & indices are already updated there, so we will just clear the
+     *       fragmented state during commit read.
+     */
+    if (rbInfo->fragmentedPeekF == c_TRUE)
+    {
+        handleFragmentedCommit(rbInfo);
+    }
+    else
+    {
+        if (dataBytes != rbInfo->entry[rbInfo->readIndex].dataLen)
+        {
+            EPRINT("data size to commit does not match the peeked data size: [dataBytes=%lu], [peekedDataSize=%u]", dataBytes,
+                   rbInfo->entry[rbInfo->readIndex].dataLen);
+            return c_FALSE;
+        }
+
+        advanceReader(rbInfo, dataBytes);
+    }
+
+    consumeRecords(rbInfo, 1);
+    TRACE_PROBE3(ringbuffer, commit, rbInfo->bufferHandle, rbInfo->peekRawLen, getOccupiedSpace(rbInfo));
+
+    if (rbInfo->highWatermark != 0)
+    {
+        checkWatermarks(rbInfo);
+    }
+
+    if (IS_NO_DATA_TO_READ(rbInfo) && (getTotalUnreadIndexCount(rbInfo->ownerHandle) == 0))
+    {
+        clearBufferReady(rbInfo->ownerHandle);
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Handle reading fragmented data from the buffer.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param readPtr Pointer to store the read pointer.
+ * @param dataBytes Pointer to store the size of the read data in bytes.
+ * @return cBool Returns c_TRUE if the fragmented data is handled successfully, otherwise c_FALSE.
+ */
+static cBool handleFragmentedPeek(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes)
+{
+    cU64_t part1Bytes, part2Bytes;
+
+    part1Bytes = rbInfo->entry[rbInfo->readIndex].dataLen;
+    part2Bytes = rbInfo->entry[(rbInfo->readIndex + 1) % MAX_DATA_INDEX].dataLen;
+
+    // Grow the reassembly memory before touching any index, so a failure leaves the buffer as it was
+    if (growScratch(rbInfo, &rbInfo->fragmentedDataPtr, &rbInfo->fragmentedDataSize, part1Bytes + part2Bytes) == c_FALSE)
+    {
+        EPRINT("failed to allocate memory for reading fragmented data: [dataBytes=%lu]", part1Bytes + part2Bytes);
+        return c_FALSE;
+    }
+
+    rbInfo->readIndex = (rbInfo->readIndex + 2) % MAX_DATA_INDEX;
+    rbInfo->fragmentedPeekF = c_TRUE;
+
+    // Copy fragmented data into the reassembly memory
+    memcpy(rbInfo->fragmentedDataPtr, RING_PTR(rbInfo, rbInfo->readOffset), part1Bytes);
+    memcpy((rbInfo->fragmentedDataPtr + part1Bytes), rbInfo->pBufferBegin, part2Bytes);
+    rbInfo->readOffset += part1Bytes + part2Bytes;
+
+    *readPtr = rbInfo->fragmentedDataPtr;
+    *dataBytes = (part1Bytes + part2Bytes);
+    TRACE_PROBE3(ringbuffer, peek_fragmented, rbInfo->bufferHandle, *dataBytes, getOccupiedSpace(rbInfo));
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Handle reading compressed data from the buffer, decoded into the reassembly memory.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param readPtr Pointer to store the read pointer.
+ * @param dataBytes Pointer to store the size of the read data in bytes.
+ * @return cBool Returns c_TRUE if the record is decoded successfully, otherwise c_FALSE with dataBytes set to 0 if
+ *         nothing was consumed, or to the stored size if the record does not decode and has to be committed.
+ */
+static cBool handleCompressedPeek(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes)
+{
+    cU64_t dataIndex = rbInfo->readIndex;
+    cU64_t scratchBytes = getDecodeScratchBytes(rbInfo, dataIndex);
+    cU64_t decodedBytes;
+
+    // Grow the reassembly memory before touching any index, so a failure leaves the buffer as it was
+    if (growScratch(rbInfo, &rbInfo->fragmentedDataPtr, &rbInfo->fragmentedDataSize, scratchBytes) == c_FALSE)
+    {
+        EPRINT("failed to allocate memory for decoding compressed data: [dataBytes=%lu]", scratchBytes);
+        *dataBytes = 0;
+        return c_FALSE;
+    }
+
+    decodedBytes = decodeRecord(rbInfo, dataIndex, rbInfo->fragmentedDataPtr);
+
+    // Cursors move past the record as for a reassembled one, the commit only clears the peek state
+    if (IS_DATA_FRAGMENTED(rbInfo))
+    {
+        rbInfo->readIndex = (rbInfo->readIndex + 2) % MAX_DATA_INDEX;
+        rbInfo->readOffset += rbInfo->entry[dataIndex].dataLen + rbInfo->entry[(dataIndex + 1) % MAX_DATA_INDEX].dataLen;
+    }
+    else
+    {
+        advanceReader(rbInfo, rbInfo->entry[dataIndex].dataLen);
+    }
+
+    rbInfo->fragmentedPeekF = c_TRUE;
+    *readPtr = rbInfo->fragmentedDataPtr;
+
+    if (decodedBytes == 0)
+    {
+        // Commit drops the record, any non zero size is accepted for a record past the cursors
+        *dataBytes = rbInfo->entry[dataIndex].dataLen;
+        return c_FALSE;
+    }
+
+    *dataBytes = decodedBytes;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Handle committing a read of fragmented data.
+ * @param rbInfo Pointer to the ring buffer information.
+ */
+static void handleFragmentedCommit(Rb_Info_t *rbInfo)
+{
+    rbInfo->fragmentedPeekF = c_FALSE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Advance the reader pointer and index after committing a read.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param dataBytes Size of the data read in bytes.
+ */
+static void advanceReader(Rb_Info_t *rbInfo, cU64_t dataBytes)
+{
+    rbInfo->readOffset += dataBytes;
+    rbInfo->readIndex++;
+
+    if (rbInfo->readIndex == MAX_DATA_INDEX)
+    {
+        rbInfo->readIndex = 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Move the writer of an empty buffer to the beginning of the next lap.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @note  Only writer fields are written. The consumer cursors stay in the skipped tail until the next record is
+ *        read, the compaction offset tells the writer that the tail holds no data.
+ */
+static void compactWriter(Rb_Info_t *rbInfo)
+{
+    rbInfo->writeOffset += rbInfo->size - RING_POS(rbInfo, rbInfo->writeOffset);
+    rbInfo->compactOffset = rbInfo->writeOffset;
+
+    if (rbInfo->groupOpenF == c_TRUE)
+    {
+        // Group has no records yet, an abort has to return to the compacted writer
+        markGroupStart(rbInfo);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the offset of a record from a cursor less than one lap behind it.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param baseOffset Offset at or before the record, moved past the last compaction.
+ * @param dataIndex Index of the record.
+ * @return cU64_t Returns the offset of the first byte of the record.
+ * @note  All data lies within one lap past the consumer cursors once they are moved past the last compaction,
+ *        so the position of the record in the buffer is enough to find its lap.
+ */
+static cU64_t getRecordOffset(const Rb_Info_t *rbInfo, cU64_t baseOffset, cU64_t dataIndex)
+{
+    cU64_t basePos = RING_POS(rbInfo, baseOffset);
+    cU64_t dataOffset = rbInfo->entry[dataIndex].dataOffset;
+
+    return (baseOffset - basePos) + dataOffset + ((dataOffset < basePos) ? rbInfo->size : 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+ * @brief Get the count of published unread indices in the buffer.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @return cU64_t Returns the count of unread indices visible to the reader.
+ */
+static cU64_t getUnreadIndexCount(Rb_Info_t *rbInfo)
+{
+    if (rbInfo->readIndex > rbInfo->pubWriteIndex)
+    {
+        return (MAX_DATA_INDEX - (rbInfo->readIndex - rbInfo->pubWriteIndex));
+    }
+    else
+    {
+        return (rbInfo->pubWriteIndex - rbInfo->readIndex);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the count of indices in use by unread and retained records.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @return cU64_t Returns the count of used indices.
+ */
+static cU64_t getUsedIndexCount(Rb_Info_t *rbInfo)
+{
+    if (rbInfo->retainIndex > rbInfo->writeIndex)
+    {
+        return (MAX_DATA_INDEX - (rbInfo->retainIndex - rbInfo->writeIndex));
+    }
+    else
+    {
+        return (rbInfo->writeIndex - rbInfo->retainIndex);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get contiguous free size in the buffer.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @return cU64_t Returns the free size in bytes up to the end of the buffer memory.
+ */
+static cU64_t getContiguousFreeSpace(Rb_Info_t *rbInfo)
+{
+    cU64_t tailBytes = rbInfo->size - RING_POS(rbInfo, rbInfo->writeOffset);
+    cU64_t freeSpace = getFreeSpace(rbInfo);
+
+    return (tailBytes < freeSpace) ? tailBytes : freeSpace;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get free size in the buffer.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @return cU64_t Returns the free size in bytes.
+ * @note  Offsets never wrap, so a full and an empty buffer differ by a whole lap and no gap byte is needed.
+ */
+static cU64_t getFreeSpace(Rb_Info_t *rbInfo)
+{
+    return rbInfo->size - (rbInfo->writeOffset - PAST_COMPACTION(rbInfo, rbInfo->retainOffset));
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get occupied size in the buffer.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @return cU64_t Returns the occupied size in bytes.
+ */
+static cU64_t getOccupiedSpace(Rb_Info_t *rbInfo)
+{
+    return rbInfo->writeOffset - PAST_COMPACTION(rbInfo, rbInfo->readOffset);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set the ready bit of the buffer, called when it goes from empty to non-empty.
+ * @param bufferHandle Handle of the buffer.
+ */
+static void markBufferReady(cI32_t bufferHandle)
+{
+    cI32_t slotId = GET_SLOT_ID(bufferHandle);
+
+    __atomic_fetch_or(&GET_CONTEXT(bufferHandle)->readyMap[slotId / READY_MAP_WORD_BITS],
+                      (1ULL << (slotId % READY_MAP_WORD_BITS)), __ATOMIC_RELEASE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Clear the ready bit of the buffer, called when it is drained or destroyed.
+ * @param bufferHandle Handle of the buffer.
+ */
+static void clearBufferReady(cI32_t bufferHandle)
+{
+    cI32_t slotId = GET_SLOT_ID(bufferHandle);
+
+    __atomic_fetch_and(&GET_CONTEXT(bufferHandle)->readyMap[slotId / READY_MAP_WORD_BITS],
+                       ~(1ULL << (slotId % READY_MAP_WORD_BITS)), __ATOMIC_RELEASE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Find the first ready slot at or after the start slot, wrapping around the slots of the context.
+ * @param context Context to search.
+ * @param startSlotId Slot to start the search from.
+ * @return cI32_t Returns the ready slot, or INVALID_BUFFER_HANDLE if no buffer is ready.
+ * @note  Scans a whole 64-bit word per step and picks the lowest set bit with ctz, so the cost depends on
+ *        the number of words and not on the number of handles.
+ */
+static cI32_t findReadyHandle(Rb_Context_t *context, cI32_t startSlotId)
+{
+    cU32_t wordId, scanCnt;
+    cU64_t readyBits;
+
+    if ((startSlotId < 0) || (startSlotId >= MAX_BUFFER_HANDLE))
+    {
+        startSlotId = 0;
+    }
+
+    wordId = (cU32_t)startSlotId / READY_MAP_WORD_BITS;
+
+    // Mask off the slots below the start slot in the first word, they are visited last
+    readyBits = __atomic_load_n(&context->readyMap[wordId], __ATOMIC_ACQUIRE) & (~0ULL << (startSlotId % READY_MAP_WORD_BITS));
+
+    for (scanCnt = 0; scanCnt <= READY_MAP_WORDS; scanCnt++)
+    {
+        if (readyBits != 0)
+        {
+            return (cI32_t)((wordId * READY_MAP_WORD_BITS) + __builtin_ctzll(readyBits));
+        }
+
+        wordId++;
+        if (wordId == READY_MAP_WORDS)
+        {
+            wordId = 0;
+        }
+
+        readyBits = __atomic_load_n(&context->readyMap[wordId], __ATOMIC_ACQUIRE);
+    }
+
+    return INVALID_BUFFER_HANDLE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Compare the checksum of the peeked data with the one computed at write.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param readPtr Pointer to the peeked data.
+ * @param dataBytes Size of the peeked data in bytes.
+ * @return cBool Returns c_TRUE if the checksum matches, otherwise c_FALSE
+ */
+static cBool verifyPeekedData(Rb_Info_t *rbInfo, const cU8_t *readPtr, cU64_t dataBytes)
+{
+    cU32_t dataCrc = Crc32c_Compute(readPtr, dataBytes);
+
+    if (dataCrc != rbInfo->peekCrc)
+    {
+        EPRINT("data checksum mismatch: [bufferHandle=%d], [dataBytes=%lu], [expected=0x%08x], [actual=0x%08x]",
+               rbInfo->bufferHandle, dataBytes, rbInfo->peekCrc, dataCrc);
+        return c_FALSE;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Compress the record into the codec scratch memory.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param data Pointer to the record.
+ * @param dataBytes Size of the record in bytes.
+ * @param encodedBytes Pointer to store the size of the compressed record in bytes.
+ * @return cBool Returns c_TRUE if the record compressed well enough to be stored compressed, otherwise c_FALSE
+ */
+static cBool encodeRecord(Rb_Info_t *rbInfo, const cU8_t *data, cU64_t dataBytes, cU64_t *encodedBytes)
+{
+    // Compressor gives up as soon as the output exceeds the size worth storing
+    cU64_t maxEncodedBytes = dataBytes - (dataBytes / MIN_COMPRESS_SAVING);
+
+    if (growScratch(rbInfo, &rbInfo->codecBuf, &rbInfo->codecBufSize, maxEncodedBytes) == c_FALSE)
+    {
+        WPRINT("failed to grow codec memory, storing record raw: [needBytes=%lu]", maxEncodedBytes);
+        return c_FALSE;
+    }
+
+    cU64_t compressedBytes = Lz_Compress(data, dataBytes, rbInfo->codecBuf, maxEncodedBytes);
+    if (compressedBytes == 0)
+    {
+        return c_FALSE;
+    }
+
+    *encodedBytes = compressedBytes;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the scratch memory needed to decode the compressed record at the index.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param dataIndex Index of the first part of the record.
+ * @return cU64_t Returns the size in bytes, the raw length plus the stored bytes of a fragmented record.
+ */
+static cU64_t getDecodeScratchBytes(const Rb_Info_t *rbInfo, cU64_t dataIndex)
+{
+    cU64_t scratchBytes = rbInfo->entry[dataIndex].rawLen;
+
+    if (rbInfo->entry[dataIndex].flags & RECORD_FLAG_FRAGMENTED)
+    {
+        // Decoder needs contiguous input, the parts are joined behind the decoded record
+        scratchBytes += rbInfo->entry[dataIndex].dataLen + rbInfo->entry[(dataIndex + 1) % MAX_DATA_INDEX].dataLen;
+    }
+
+    return scratchBytes;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Decompress the compressed record at the index into scratch memory.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param dataIndex Index of the first part of the record.
+ * @param scratchBuf Pointer to scratch memory of at least getDecodeScratchBytes() bytes.
+ * @return cU64_t Returns the size of the decoded record in bytes, 0 if it does not decode to its raw length.
+ */
+static cU64_t decodeRecord(const Rb_Info_t *rbInfo, cU64_t dataIndex, cU8_t *scratchBuf)
+{
+    const Rb_IndexEntry_t *pEntry = &rbInfo->entry[dataIndex];
+    const cU8_t           *storedPtr = rbInfo->pBufferBegin + pEntry->dataOffset;
+    cU64_t                 storedBytes = pEntry->dataLen;
+    cU64_t                 rawBytes = pEntry->rawLen;
+
+    if (pEntry->flags & RECORD_FLAG_FRAGMENTED)
+    {
+        cU64_t part2Bytes = rbInfo->entry[(dataIndex + 1) % MAX_DATA_INDEX].dataLen;
+
+        memcpy(scratchBuf + rawBytes, storedPtr, storedBytes);
+        memcpy(scratchBuf + rawBytes + storedBytes, rbInfo->pBufferBegin, part2Bytes);
+        storedPtr = scratchBuf + rawBytes;
+        storedBytes += part2Bytes;
+    }
+
+    if (Lz_Decompress(storedPtr, storedBytes, scratchBuf, rawBytes) != rawBytes)
+    {
+        EPRINT("failed to decompress record: [bufferHandle=%d], [storedBytes=%lu]", rbInfo->bufferHandle, storedBytes);
+        return 0;
+    }
+
+    return rawBytes;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Move consumed records to the retained region and reclaim the ones beyond the retention window.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param recordCnt Number of records just consumed.
+ * @note  Space is released to the writer only once the release batch is complete, until then the consumed
+ *        records are kept as if retained.
+ */
+static void consumeRecords(Rb_Info_t *rbInfo, cU64_t recordCnt)
+{
+    rbInfo->retainCount += recordCnt;
+    rbInfo->releasePending += recordCnt;
+
+    if ((rbInfo->releasePending != 0) && (rbInfo->releasePending < rbInfo->releaseRecords))
+    {
+        return;
+    }
+
+    rbInfo->releasePending = 0;
+
+    while (rbInfo->retainCount > rbInfo->retainRecords)
+    {
+        dropOldestRetained(rbInfo);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Reclaim the oldest retained record, making its space available to the writer.
+ * @param rbInfo Pointer to the ring buffer information.
+ */
+static void dropOldestRetained(Rb_Info_t *rbInfo)
+{
+    cU64_t indexCnt = (rbInfo->entry[rbInfo->retainIndex].flags & RECORD_FLAG_FRAGMENTED) ? 2 : 1;
+    cU64_t endOffset = getRecordOffset(rbInfo, PAST_COMPACTION(rbInfo, rbInfo->retainOffset), rbInfo->retainIndex) +
+                       rbInfo->entry[rbInfo->retainIndex].dataLen;
+
+    if (indexCnt == 2)
+    {
+        endOffset += rbInfo->entry[(rbInfo->retainIndex + 1) % MAX_DATA_INDEX].dataLen;
+    }
+
+    rbInfo->retainCount--;
+    rbInfo->oldestSeq++;
+    rbInfo->retainIndex = (rbInfo->retainIndex + indexCnt) % MAX_DATA_INDEX;
+    rbInfo->retainOffset = (rbInfo->retainIndex == rbInfo->readIndex) ? rbInfo->readOffset
+                                                                        : getRecordOffset(rbInfo, endOffset, rbInfo->retainIndex);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Publish the pending writes to the reader and mark the buffer ready if it was empty.
+ * @param rbInfo Pointer to the ring buffer information.
+ */
+static void publishWrites(Rb_Info_t *rbInfo)
+{
+    cBool wasEmptyF = IS_NO_DATA_TO_READ(rbInfo);
+
+    rbInfo->pubWriteOffset = rbInfo->writeOffset;
+    rbInfo->pubSeq = rbInfo->nextSeq;
+    rbInfo->pubWriteIndex = rbInfo->writeIndex;
+    rbInfo->pendingRecords = 0;
+    rbInfo->pendingBytes = 0;
+
+    if (wasEmptyF == c_TRUE)
+    {
+        // Buffer went from empty to non-empty, lanes signal through the buffer owning them
+        markBufferReady(rbInfo->ownerHandle);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Remember the writer state an abort of the write group returns to.
+ * @param rbInfo Pointer to the ring buffer information.
+ */
+static void markGroupStart(Rb_Info_t *rbInfo)
+{
+    rbInfo->groupWriteIndex = rbInfo->writeIndex;
+    rbInfo->groupWriteOffset = rbInfo->writeOffset;
+    rbInfo->groupSeq = rbInfo->nextSeq;
+    rbInfo->groupPendingRecords = rbInfo->pendingRecords;
+    rbInfo->groupPendingBytes = rbInfo->pendingBytes;
+    rbInfo->groupFragmentedRecords = rbInfo->stats.fragmentedRecords;
+    rbInfo->groupPaddedRecords = rbInfo->stats.paddedRecords;
+    rbInfo->groupPaddingBytes = rbInfo->stats.paddingBytes;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Prefetch the record prefetchDepth records ahead of the reader.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @note  Records in between were prefetched by the previous peeks, so one record per peek keeps the pipeline
+ *        full. The index entry of the record after it is prefetched too, so the next call finds it in cache.
+ */
+static void prefetchRecords(Rb_Info_t *rbInfo)
+{
+    cU64_t       unreadIndexCount = getUnreadIndexCount(rbInfo);
+    cU64_t       dataIndex;
+    const cU8_t *pData;
+
+    if (rbInfo->prefetchDepth >= unreadIndexCount)
+    {
+        // Nothing that far ahead has been published yet
+        return;
+    }
+
+    dataIndex = (rbInfo->readIndex + rbInfo->prefetchDepth) % MAX_DATA_INDEX;
+    pData = rbInfo->pBufferBegin + rbInfo->entry[dataIndex].dataOffset;
+
+    __builtin_prefetch(pData, 0, 3);
+    if (rbInfo->entry[dataIndex].dataLen > CACHE_LINE_BYTES)
+    {
+        __builtin_prefetch(pData + CACHE_LINE_BYTES, 0, 3);
+    }
+
+    dataIndex = (dataIndex + 1) % MAX_DATA_INDEX;
+    __builtin_prefetch(&rbInfo->entry[dataIndex], 0, 3);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Peek the next record of the buffer, from the lane picked by the lane policy.
+ * @param rbInfo Pointer to the ring buffer information of the buffer.
+ * @param readPtr Pointer to store the read pointer.
+ * @param dataBytes Pointer to store the size of the read data in bytes.
+ * @return cBool Returns c_TRUE if the data is read successfully, otherwise c_FALSE.
+ */
+static cBool peekBuffer(Rb_Info_t *rbInfo, cU8_t **readPtr, cU64_t *dataBytes)
+{
+    if ((rbInfo->tagFilter != ALL_TAGS) || (rbInfo->ttlNs != 0))
+    {
+        skipFilteredLanes(rbInfo);
+    }
+
+    if (rbInfo->laneCnt == 1)
+    {
+        return peekRecord(rbInfo, readPtr, dataBytes, c_TRUE);
+    }
+
+    if (rbInfo->peekLane->readCommittedF == c_FALSE)
+    {
+        EPRINT("previous read not committed");
+        return c_FALSE;
+    }
+
+    selectLane(rbInfo->bufferHandle);
+    return peekRecord(rbInfo->peekLane, readPtr, dataBytes, c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Move the reader of the buffer or lane to the first record written at or after the given time.
+ * @param rbInfo Pointer to the ring buffer information of the buffer or hidden lane.
+ * @param timeStampNs Time in nanoseconds, as returned by Rb_GetTimeNs.
+ * @note  Both parts of a fragmented record carry the same stamp, so the search always lands on the first part.
+ */
+static void seekLaneToTime(Rb_Info_t *rbInfo, cU64_t timeStampNs)
+{
+    cU64_t lowIdx, highIdx, midIdx, unreadIndexCount, targetIndex, droppedCnt, targetOffset;
+
+    unreadIndexCount = getUnreadIndexCount(rbInfo);
+    lowIdx = 0;
+    highIdx = unreadIndexCount;
+    while (lowIdx < highIdx)
+    {
+        midIdx = lowIdx + ((highIdx - lowIdx) / 2);
+        if (rbInfo->entry[(rbInfo->readIndex + midIdx) % MAX_DATA_INDEX].timeStamp < timeStampNs)
+        {
+            lowIdx = midIdx + 1;
+        }
+        else
+        {
+            highIdx = midIdx;
+        }
+    }
+
+    if (lowIdx == 0)
+    {
+        // Nothing older than the given time
+        return;
+    }
+
+    if (lowIdx == unreadIndexCount)
+    {
+        // Everything is older than the given time
+        targetIndex = rbInfo->pubWriteIndex;
+        droppedCnt = rbInfo->pubSeq - rbInfo->entry[rbInfo->readIndex].seq;
+        targetOffset = rbInfo->pubWriteOffset;
+    }
+    else
+    {
+        targetIndex = (rbInfo->readIndex + lowIdx) % MAX_DATA_INDEX;
+        droppedCnt = rbInfo->entry[targetIndex].seq - rbInfo->entry[rbInfo->readIndex].seq;
+        targetOffset = getRecordOffset(rbInfo, PAST_COMPACTION(rbInfo, rbInfo->readOffset), targetIndex);
+    }
+
+    rbInfo->readOffset = targetOffset;
+    rbInfo->readIndex = targetIndex;
+
+    // Dropped records count as consumed, so they stay available for replay within the retention window
+    consumeRecords(rbInfo, droppedCnt);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Skip the records the tag filter of the buffer does not serve and the expired records in every lane
+ *        without a peek outstanding.
+ * @param rbInfo Pointer to the ring buffer information of the buffer.
+ */
+static void skipFilteredLanes(Rb_Info_t *rbInfo)
+{
+    cU64_t expireBeforeNs = 0;
+    cU32_t laneId;
+
+    if (rbInfo->ttlNs != 0)
+    {
+        // One clock read per peek covers all lanes
+        cU64_t nowNs = Utils_GetMonotonicTimeNs();
+
+        expireBeforeNs = (nowNs > rbInfo->ttlNs) ? (nowNs - rbInfo->ttlNs) : 0;
+    }
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        Rb_Info_t *laneInfo = &RB_INFO(rbInfo->laneHandle[laneId]);
+
+        if (laneInfo->readCommittedF == c_TRUE)
+        {
+            skipFilteredRecords(laneInfo, rbInfo->tagFilter, expireBeforeNs);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Consume the unread records at the reader whose tag is not in the filter or that are expired.
+ * @param rbInfo Pointer to the ring buffer information of the buffer or hidden lane.
+ * @param tagFilter Tags to stop at.
+ * @param expireBeforeNs Records stamped before this time are expired, 0 to expire nothing.
+ * @note  Only the record index is read, the payload of skipped records is never touched. Records written
+ *        without a time stamp never expire.
+ */
+static void skipFilteredRecords(Rb_Info_t *rbInfo, cU64_t tagFilter, cU64_t expireBeforeNs)
+{
+    cU64_t skippedCnt = 0, expiredCnt = 0;
+    cU64_t timeStampNs;
+
+    while (IS_NO_DATA_TO_READ(rbInfo) == c_FALSE)
+    {
+        timeStampNs = (rbInfo->timeStampF == c_TRUE) ? rbInfo->entry[rbInfo->readIndex].timeStamp : 0;
+
+        if ((timeStampNs != 0) && (timeStampNs < expireBeforeNs))
+        {
+            expiredCnt++;
+        }
+        else if ((TAG_BIT(rbInfo->entry[rbInfo->readIndex].tag) & tagFilter) == 0)
+        {
+            skippedCnt++;
+        }
+        else
+        {
+            break;
+        }
+
+        rbInfo->readIndex = (rbInfo->readIndex + (IS_DATA_FRAGMENTED(rbInfo) ? 2 : 1)) % MAX_DATA_INDEX;
+    }
+
+    if ((skippedCnt + expiredCnt) == 0)
+    {
+        return;
+    }
+
+    rbInfo->readOffset = IS_NO_DATA_TO_READ(rbInfo)
+                             ? rbInfo->pubWriteOffset
+                             : getRecordOffset(rbInfo, PAST_COMPACTION(rbInfo, rbInfo->readOffset), rbInfo->readIndex);
+    rbInfo->stats.skippedRecords += skippedCnt;
+    rbInfo->stats.expiredRecords += expiredCnt;
+
+    // Skipped records count as consumed, so they stay available for replay within the retention window
+    consumeRecords(rbInfo, skippedCnt + expiredCnt);
+
+    if (rbInfo->highWatermark != 0)
+    {
+        checkWatermarks(rbInfo);
+    }
+
+    if (IS_NO_DATA_TO_READ(rbInfo) && (getTotalUnreadIndexCount(rbInfo->ownerHandle) == 0))
+    {
+        clearBufferReady(rbInfo->ownerHandle);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Raise or clear backpressure when the occupancy of the buffer, summed over its lanes, crosses a watermark.
+ * @param laneInfo Pointer to the ring buffer information of the buffer or hidden lane that changed.
+ */
+static void checkWatermarks(Rb_Info_t *laneInfo)
+{
+    Rb_Info_t *rbInfo = &RB_INFO(laneInfo->ownerHandle);
+    cU64_t     occupiedBytes = 0;
+    cU32_t     laneId;
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        occupiedBytes += getOccupiedSpace(&RB_INFO(rbInfo->laneHandle[laneId]));
+    }
+
+    if ((rbInfo->aboveHighF == c_FALSE) && (occupiedBytes >= rbInfo->highWatermark))
+    {
+        __atomic_store_n(&rbInfo->aboveHighF, c_TRUE, __ATOMIC_RELEASE);
+        if (rbInfo->watermarkCb != NULL)
+        {
+            rbInfo->watermarkCb(rbInfo->bufferHandle, Rb_Watermark_HIGH, occupiedBytes, rbInfo->watermarkUserData);
+        }
+    }
+    else if ((rbInfo->aboveHighF == c_TRUE) && (occupiedBytes <= rbInfo->lowWatermark))
+    {
+        __atomic_store_n(&rbInfo->aboveHighF, c_FALSE, __ATOMIC_RELEASE);
+        if (rbInfo->watermarkCb != NULL)
+        {
+            rbInfo->watermarkCb(rbInfo->bufferHandle, Rb_Watermark_LOW, occupiedBytes, rbInfo->watermarkUserData);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Set or remove the write rate limit of the buffer or lane, starting with full buckets.
+ * @param rbInfo Pointer to the ring buffer information of the buffer or hidden lane.
+ * @param rateLimit Rates and bursts, bursts already defaulted and checked. NULL removes the limit.
+ */
+static void applyRateLimit(Rb_Info_t *rbInfo, const Rb_RateLimit_t *rateLimit)
+{
+    cU64_t nowNs = Utils_GetCoarseTimeNs();
+
+    if (rateLimit == NULL)
+    {
+        rbInfo->rateLimitF = c_FALSE;
+        return;
+    }
+
+    rbInfo->rateLimit = *rateLimit;
+
+    rbInfo->byteBucket.tokens = (cI64_t)rateLimit->burstBytes;
+    rbInfo->byteBucket.refillNs = nowNs;
+    rbInfo->byteBucket.fillNs = (rateLimit->bytesPerSec != 0) ? (rateLimit->burstBytes * NANO_SECONDS_PER_SECOND) / rateLimit->bytesPerSec : 0;
+
+    rbInfo->recordBucket.tokens = (cI64_t)rateLimit->burstRecords;
+    rbInfo->recordBucket.refillNs = nowNs;
+    rbInfo->recordBucket.fillNs =
+        (rateLimit->recordsPerSec != 0) ? (rateLimit->burstRecords * NANO_SECONDS_PER_SECOND) / rateLimit->recordsPerSec : 0;
+
+    rbInfo->rateLimitF = c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Add the tokens earned since the last refill to a token bucket.
+ * @param bucket Pointer to the token bucket.
+ * @param rate Tokens earned per second.
+ * @param burst Maximum number of tokens in the bucket.
+ * @param nowNs Current coarse time in nanoseconds.
+ * @note  Only the time converted to whole tokens is consumed, so slow rates still refill with a coarse clock.
+ */
+static void refillTokenBucket(Rb_TokenBucket_t *bucket, cU64_t rate, cU64_t burst, cU64_t nowNs)
+{
+    cU64_t elapsedNs = nowNs - bucket->refillNs;
+    cU64_t earned;
+
+    // Debt of a record larger than the burst is paid off one full bucket at a time
+    while ((bucket->tokens < 0) && (bucket->fillNs != 0) && (elapsedNs >= bucket->fillNs))
+    {
+        bucket->tokens += (cI64_t)burst;
+        bucket->refillNs += bucket->fillNs;
+        elapsedNs -= bucket->fillNs;
+    }
+
+    if (elapsedNs >= bucket->fillNs)
+    {
+        bucket->tokens = (cI64_t)burst;
+        bucket->refillNs = nowNs;
+        return;
+    }
+
+    // Elapsed time is below the fill time, so the product stays below burst * NANO_SECONDS_PER_SECOND
+    earned = (elapsedNs * rate) / NANO_SECONDS_PER_SECOND;
+    if (earned == 0)
+    {
+        return;
+    }
+
+    bucket->tokens = ((bucket->tokens + (cI64_t)earned) < (cI64_t)burst) ? (bucket->tokens + (cI64_t)earned) : (cI64_t)burst;
+    bucket->refillNs += (earned * NANO_SECONDS_PER_SECOND) / rate;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Take the tokens of a record from the rate limit buckets of the buffer or lane.
+ * @param rbInfo Pointer to the ring buffer information of the buffer or hidden lane.
+ * @param dataBytes Size of the record in bytes before encoding.
+ * @return cBool Returns c_TRUE if the record may be written, otherwise c_FALSE and no tokens are taken.
+ * @note  Buckets belong to the producer like the write cursor, so they need no atomics, and the coarse clock
+ *        is read from the vDSO, so a write never makes a system call for shaping.
+ */
+static cBool takeRateTokens(Rb_Info_t *rbInfo, cU64_t dataBytes)
+{
+    cU64_t nowNs = Utils_GetCoarseTimeNs();
+
+    if (rbInfo->rateLimit.bytesPerSec != 0)
+    {
+        refillTokenBucket(&rbInfo->byteBucket, rbInfo->rateLimit.bytesPerSec, rbInfo->rateLimit.burstBytes, nowNs);
+        if (rbInfo->byteBucket.tokens <= 0)
+        {
+            return c_FALSE;
+        }
+    }
+
+    if (rbInfo->rateLimit.recordsPerSec != 0)
+    {
+        refillTokenBucket(&rbInfo->recordBucket, rbInfo->rateLimit.recordsPerSec, rbInfo->rateLimit.burstRecords, nowNs);
+        if (rbInfo->recordBucket.tokens <= 0)
+        {
+            return c_FALSE;
+        }
+        rbInfo->recordBucket.tokens--;
+    }
+
+    // Records larger than the balance go into debt, paid off before the next record passes
+    if (rbInfo->rateLimit.bytesPerSec != 0)
+    {
+        rbInfo->byteBucket.tokens -= (cI64_t)dataBytes;
+    }
+
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Pick the lane served by the next peek read and store it as the peek lane of the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @note  Strict serves the highest non-empty lane. Weighted serves the highest non-empty lane with credit
+ *        left and refills all credits when none has, so each lane gets its weight picks per round.
+ */
+static void selectLane(cI32_t bufferHandle)
+{
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+    cI32_t     laneId, creditLane = -1, readyLane = -1;
+
+    for (laneId = (cI32_t)rbInfo->laneCnt - 1; laneId >= 0; laneId--)
+    {
+        if (getUnreadIndexCount(&RB_INFO(rbInfo->laneHandle[laneId])) == 0)
+        {
+            continue;
+        }
+
+        if (readyLane < 0)
+        {
+            readyLane = laneId;
+        }
+
+        if ((rbInfo->lanePolicy == Rb_LanePolicy_STRICT) || (rbInfo->laneCredit[laneId] > 0))
+        {
+            creditLane = laneId;
+            break;
+        }
+    }
+
+    if (readyLane < 0)
+    {
+        // Nothing to read, peek reports it on lane 0
+        rbInfo->peekLane = rbInfo;
+        return;
+    }
+
+    if (creditLane < 0)
+    {
+        // Every non-empty lane used up its picks, start a new round
+        for (laneId = 0; laneId < (cI32_t)rbInfo->laneCnt; laneId++)
+        {
+            rbInfo->laneCredit[laneId] = rbInfo->laneWeight[laneId];
+        }
+
+        creditLane = readyLane;
+    }
+
+    if (rbInfo->lanePolicy == Rb_LanePolicy_WEIGHTED)
+    {
+        rbInfo->laneCredit[creditLane]--;
+    }
+
+    rbInfo->peekLane = &RB_INFO(rbInfo->laneHandle[creditLane]);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the count of published unread indices over all lanes of the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @return cU64_t Returns the count of unread indices.
+ */
+static cU64_t getTotalUnreadIndexCount(cI32_t bufferHandle)
+{
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+    cU64_t     unreadIndexCount = 0;
+    cU32_t     laneId;
+
+    for (laneId = 0; laneId < rbInfo->laneCnt; laneId++)
+    {
+        unreadIndexCount += getUnreadIndexCount(&RB_INFO(rbInfo->laneHandle[laneId]));
+    }
+
+    return unreadIndexCount;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Free the memory of a buffer or lane slot and mark the slot unused.
+ * @param bufferHandle Handle of the slot.
+ */
+static void releaseBufferSlot(cI32_t bufferHandle)
+{
+    Rb_Info_t *rbInfo = &RB_INFO(bufferHandle);
+
+    freeMemory(rbInfo, &rbInfo->pBufferBegin, rbInfo->size);
+    rbInfo->fragmentedPeekF = c_FALSE;
+    trimScratch(rbInfo);
+
+    if (rbInfo->ownerHandle == bufferHandle)
+    {
+        clearBufferReady(bufferHandle);
+    }
+
+    rbInfo->bufferHandle = INVALID_BUFFER_HANDLE;
+    rbInfo->ownerHandle = bufferHandle;
+    rbInfo->generation = nextGeneration();
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get a slot generation no slot has had before.
+ * @return cU32_t Returns the generation.
+ * @note  Drawn from one module wide counter, so a reference kept across a module or context re-initialization
+ *        never matches the slot again.
+ */
+static cU32_t nextGeneration(void)
+{
+    return __atomic_add_fetch(&gRbGeneration, 1, __ATOMIC_RELAXED);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check if the record can be written with the wrap policy of the buffer.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @param dataBytes Size of the record in bytes.
+ * @return cBool Returns c_TRUE if there is room for the record, otherwise c_FALSE
+ */
+static cBool isSpaceForRecord(Rb_Info_t *rbInfo, cU64_t dataBytes)
+{
+    if (getContiguousFreeSpace(rbInfo) >= dataBytes)
+    {
+        return c_TRUE;
+    }
+
+    if (rbInfo->wrapPolicy == Rb_WrapPolicy_SPLIT)
+    {
+        return (getFreeSpace(rbInfo) >= dataBytes) ? c_TRUE : c_FALSE;
+    }
+
+    // Padding skips the tail, the whole record must fit in front of the oldest data
+    return ((rbInfo->size - RING_POS(rbInfo, rbInfo->writeOffset) + dataBytes) <= getFreeSpace(rbInfo)) ? c_TRUE : c_FALSE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Make sure the scratch memory holds at least the needed bytes, growing it geometrically.
+ * @param rbInfo Pointer to the ring buffer information owning the scratch memory.
+ * @param scratchBuf Pointer to the scratch memory pointer.
+ * @param scratchSize Pointer to the scratch memory size in bytes.
+ * @param needBytes Needed size in bytes.
+ * @return cBool Returns c_TRUE if the scratch memory is large enough, otherwise c_FALSE
+ * @note  On failure the scratch memory is left unchanged.
+ */
+static cBool growScratch(Rb_Info_t *rbInfo, cU8_t **scratchBuf, cU64_t *scratchSize, cU64_t needBytes)
+{
+    cU64_t newSize;
+    cU8_t *newBuf;
+
+    if (*scratchSize >= needBytes)
+    {
+        return c_TRUE;
+    }
+
+    newSize = ((*scratchSize * 2) > needBytes) ? (*scratchSize * 2) : needBytes;
+    newBuf = (cU8_t *)rbInfo->allocator.reallocFn(*scratchBuf, *scratchSize, newSize, SCRATCH_ALIGNMENT,
+                                                  rbInfo->allocator.context);
+
+    if (newBuf == NULL)
+    {
+        return c_FALSE;
+    }
+
+    *scratchBuf = newBuf;
+    *scratchSize = newSize;
+    return c_TRUE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Free the reassembly, replay and codec scratch memory of a buffer or lane slot.
+ * @param rbInfo Pointer to the ring buffer information.
+ */
+static void trimScratch(Rb_Info_t *rbInfo)
+{
+    freeMemory(rbInfo, &rbInfo->fragmentedDataPtr, rbInfo->fragmentedDataSize);
+    rbInfo->fragmentedDataSize = 0;
+    freeMemory(rbInfo, &rbInfo->codecBuf, rbInfo->codecBufSize);
+    rbInfo->codecBufSize = 0;
+    freeMemory(rbInfo, &rbInfo->replayBuf, rbInfo->replayBufSize);
+    rbInfo->replayBufSize = 0;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Reset a context to have no buffers.
+ * @param context Context to reset.
+ * @param allocator Allocator of the context and of its buffers, NULL to use the heap.
+ * @note  The context id is left to the caller, nothing else in the context depends on it until a buffer is
+ *        created.
+ */
+static void initContext(Rb_Context_t *context, const Rb_Allocator_t *allocator)
+{
+    cI32_t slotId;
+
+    for (slotId = 0; slotId < MAX_BUFFER_HANDLE; slotId++)
+    {
+        Rb_Info_t *rbInfo = &context->rbInfo[slotId];
+
+        rbInfo->pBufferBegin = NULL;
+        rbInfo->writeOffset = 0;
+        rbInfo->readOffset = 0;
+        rbInfo->retainOffset = 0;
+        rbInfo->size = 0;
+        rbInfo->entry[0].dataLen = 0;
+        rbInfo->readIndex = 0;
+        rbInfo->writeIndex = 0;
+        rbInfo->bufferHandle = INVALID_BUFFER_HANDLE;
+        rbInfo->fragmentedDataPtr = NULL;
+        rbInfo->fragmentedDataSize = 0;
+        rbInfo->fragmentedPeekF = c_FALSE;
+        rbInfo->readCommittedF = c_TRUE;
+        rbInfo->schedWeight = DEFAULT_SCHED_WEIGHT;
+        rbInfo->integrityMode = Rb_IntegrityMode_NONE;
+        rbInfo->codec = Rb_Codec_NONE;
+        rbInfo->codecBuf = NULL;
+        rbInfo->codecBufSize = 0;
+        rbInfo->timeStampF = c_FALSE;
+        rbInfo->ttlNs = 0;
+        rbInfo->compactOnEmptyF = c_TRUE;
+        rbInfo->compactOffset = 0;
+        rbInfo->tagFilter = ALL_TAGS;
+        rbInfo->rateLimitF = c_FALSE;
+        rbInfo->writeStatus = cStatus_SUCCESS;
+        rbInfo->replayBuf = NULL;
+        rbInfo->replayBufSize = 0;
+        rbInfo->pubWriteIndex = 0;
+        rbInfo->pubWriteOffset = 0;
+        rbInfo->publishRecords = DEFAULT_PUBLISH_RECORDS;
+        rbInfo->publishBytes = 0;
+        rbInfo->groupOpenF = c_FALSE;
+        rbInfo->releaseRecords = DEFAULT_RELEASE_RECORDS;
+        rbInfo->prefetchDepth = 0;
+        rbInfo->highWatermark = 0;
+        rbInfo->watermarkCb = NULL;
+        rbInfo->ownerHandle = INVALID_BUFFER_HANDLE;
+        rbInfo->generation = nextGeneration();
+        rbInfo->laneCnt = 1;
+        rbInfo->laneHandle[0] = INVALID_BUFFER_HANDLE;
+        rbInfo->peekLane = rbInfo;
+    }
+
+    for (slotId = 0; slotId < READY_MAP_WORDS; slotId++)
+    {
+        __atomic_store_n(&context->readyMap[slotId], 0, __ATOMIC_RELAXED);
+    }
+
+    context->sched.policy = Rb_SchedPolicy_ROUND_ROBIN;
+    context->sched.lastSlotId = INVALID_BUFFER_HANDLE;
+    context->sched.credit = 0;
+    context->allocator = (allocator == NULL) ? gRbDefaultAllocator : *allocator;
+    context->contextAllocator = context->allocator;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Free the buffer memory and scratch memory of all slots of the context.
+ * @param context Context to release.
+ */
+static void releaseContextMemory(Rb_Context_t *context)
+{
+    cI32_t slotId;
+
+    for (slotId = 0; slotId < MAX_BUFFER_HANDLE; slotId++)
+    {
+        freeMemory(&context->rbInfo[slotId], &context->rbInfo[slotId].pBufferBegin, context->rbInfo[slotId].size);
+        trimScratch(&context->rbInfo[slotId]);
+        context->rbInfo[slotId].generation = nextGeneration();
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Free memory with the allocator of the buffer and clear the pointer.
+ * @param rbInfo Pointer to the ring buffer information owning the memory.
+ * @param pMemory Pointer to the memory pointer.
+ * @param size Size of the memory in bytes.
+ */
+static void freeMemory(Rb_Info_t *rbInfo, cU8_t **pMemory, cU64_t size)
+{
+    if (*pMemory != NULL)
+    {
+        rbInfo->allocator.freeFn(*pMemory, size, rbInfo->allocator.context);
+        *pMemory = NULL;
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Default allocator: allocate from the heap.
+ * @param size Size in bytes.
+ * @param alignment Required alignment in bytes, a power of two.
+ * @param context Unused.
+ * @return void* Returns the memory, or NULL on failure.
+ */
+static void *defaultAlloc(cSize_t size, cSize_t alignment, void *context)
+{
+    void *pMemory = NULL;
+
+    (void)context;
+
+    if (alignment <= SCRATCH_ALIGNMENT)
+    {
+        // malloc already guarantees this alignment
+        return malloc(size);
+    }
+
+    if (posix_memalign(&pMemory, alignment, (size == 0) ? 1 : size) != 0)
+    {
+        return NULL;
+    }
+
+    return pMemory;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Default allocator: resize heap memory.
+ * @param ptr Memory to resize, NULL to allocate.
+ * @param oldSize Current size in bytes.
+ * @param newSize New size in bytes.
+ * @param alignment Required alignment in bytes, a power of two.
+ * @param context Unused.
+ * @return void* Returns the resized memory, or NULL on failure leaving ptr untouched.
+ */
+static void *defaultRealloc(void *ptr, cSize_t oldSize, cSize_t newSize, cSize_t alignment, void *context)
+{
+    void *pMemory;
+
+    if (alignment <= SCRATCH_ALIGNMENT)
+    {
+        return realloc(ptr, newSize);
+    }
+
+    // realloc does not keep a larger alignment
+    pMemory = defaultAlloc(newSize, alignment, context);
+    if ((pMemory != NULL) && (ptr != NULL))
+    {
+        memcpy(pMemory, ptr, (oldSize < newSize) ? oldSize : newSize);
+        free(ptr);
+    }
+
+    return pMemory;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Default allocator: free heap memory.
+ * @param ptr Memory to free.
+ * @param size Unused.
+ * @param context Unused.
+ */
+static void defaultFree(void *ptr, cSize_t size, void *context)
+{
+    (void)size;
+    (void)context;
+    free(ptr);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check the cursors and the record index of one buffer or lane.
+ * @param rbInfo Pointer to the ring buffer information.
+ * @return cBool Returns c_TRUE if the state is consistent, otherwise c_FALSE with the violation printed.
+ * @note  Records from the retain index to the write index must follow each other in the buffer, only jumping
+ *        to the next lap after a fragment, padding or compaction, and their count must match the sequence numbers.
+ */
+static cBool checkSlotConsistency(Rb_Info_t *rbInfo)
+{
+    cU64_t usedIndexCnt = getUsedIndexCount(rbInfo);
+    cU64_t dataIndex = rbInfo->retainIndex;
+    cU64_t recordCnt = 0, retainedCnt = 0;
+    cU64_t expectedOffset = PAST_COMPACTION(rbInfo, rbInfo->retainOffset);
+    cU64_t indexCnt;
+
+    if ((rbInfo->retainOffset > rbInfo->readOffset) || (rbInfo->readOffset > rbInfo->pubWriteOffset) ||
+        (rbInfo->pubWriteOffset > rbInfo->writeOffset) || (rbInfo->compactOffset > rbInfo->writeOffset) ||
+        ((rbInfo->writeOffset - expectedOffset) > rbInfo->size))
+    {
+        EPRINT("cursors out of order: [retain=%lu], [read=%lu], [pubWrite=%lu], [write=%lu], [compact=%lu]",
+               rbInfo->retainOffset, rbInfo->readOffset, rbInfo->pubWriteOffset, rbInfo->writeOffset, rbInfo->compactOffset);
+        return c_FALSE;
+    }
+
+    if ((rbInfo->readIndex >= MAX_DATA_INDEX) || (rbInfo->writeIndex >= MAX_DATA_INDEX) ||
+        (rbInfo->retainIndex >= MAX_DATA_INDEX) || (rbInfo->pubWriteIndex >= MAX_DATA_INDEX))
+    {
+        EPRINT("data index out of range");
+        return c_FALSE;
+    }
+
+    // Retain, read and published write indices must lie in this order between the retain and write indices
+    if (((rbInfo->readIndex + MAX_DATA_INDEX - rbInfo->retainIndex) % MAX_DATA_INDEX) +
+            ((rbInfo->pubWriteIndex + MAX_DATA_INDEX - rbInfo->readIndex) % MAX_DATA_INDEX) +
+            ((rbInfo->writeIndex + MAX_DATA_INDEX - rbInfo->pubWriteIndex) % MAX_DATA_INDEX) !=
+        usedIndexCnt)
+    {
+        EPRINT("data indices out of order: [retain=%lu], [read=%lu], [pubWrite=%lu], [write=%lu]", rbInfo->retainIndex,
+               rbInfo->readIndex, rbInfo->pubWriteIndex, rbInfo->writeIndex);
+        return c_FALSE;
+    }
+
+    if ((usedIndexCnt == 0) && (IS_BUFFER_EMPTY(rbInfo) == c_FALSE))
+    {
+        EPRINT("empty index with data in buffer");
+        return c_FALSE;
+    }
+
+    while (dataIndex != rbInfo->writeIndex)
+    {
+        cU64_t dataOffset = rbInfo->entry[dataIndex].dataOffset;
+        cU64_t recordOffset;
+
+        if (dataIndex == rbInfo->readIndex)
+        {
+            retainedCnt = recordCnt;
+        }
+
+        if ((rbInfo->entry[dataIndex].dataLen == 0) || ((dataOffset + rbInfo->entry[dataIndex].dataLen) > rbInfo->size))
+        {
+            EPRINT("record outside of buffer: [dataIndex=%lu], [dataOffset=%lu], [dataLen=%u]", dataIndex, dataOffset,
+                   rbInfo->entry[dataIndex].dataLen);
+            return c_FALSE;
+        }
+
+        // Next record follows the previous one, or starts at the next lap after a wrap, padding or compaction
+        recordOffset = getRecordOffset(rbInfo, expectedOffset, dataIndex);
+        if ((recordOffset != expectedOffset) && (dataOffset != 0))
+        {
+            EPRINT("record not contiguous: [dataIndex=%lu], [dataOffset=%lu], [expectedOffset=%lu]", dataIndex, dataOffset,
+                   RING_POS(rbInfo, expectedOffset));
+            return c_FALSE;
+        }
+
+        expectedOffset = recordOffset + rbInfo->entry[dataIndex].dataLen;
+        indexCnt = 1;
+
+        if (rbInfo->entry[dataIndex].flags & RECORD_FLAG_FRAGMENTED)
+        {
+            cU64_t nextIndex = (dataIndex + 1) % MAX_DATA_INDEX;
+
+            if ((RING_POS(rbInfo, expectedOffset) != 0) || (nextIndex == rbInfo->writeIndex) ||
+                (rbInfo->entry[nextIndex].dataOffset != 0))
+            {
+                EPRINT("fragmented record not split at the end of buffer: [dataIndex=%lu]", dataIndex);
+                return c_FALSE;
+            }
+
+            expectedOffset += rbInfo->entry[nextIndex].dataLen;
+            indexCnt = 2;
+        }
+
+        if (rbInfo->entry[dataIndex].seq != (rbInfo->oldestSeq + recordCnt))
+        {
+            EPRINT("record sequence mismatch: [dataIndex=%lu], [sequence=%lu], [expected=%lu]", dataIndex,
+                   rbInfo->entry[dataIndex].seq, rbInfo->oldestSeq + recordCnt);
+            return c_FALSE;
+        }
+
+        recordCnt++;
+        dataIndex = (dataIndex + indexCnt) % MAX_DATA_INDEX;
+    }
+
+    if (rbInfo->readIndex == rbInfo->writeIndex)
+    {
+        retainedCnt = recordCnt;
+    }
+
+    // A fragmented record being peeked has already moved the read index past it
+    if ((rbInfo->fragmentedPeekF == c_TRUE) && (retainedCnt > 0))
+    {
+        retainedCnt--;
+    }
+
+    if ((usedIndexCnt != 0) && (expectedOffset != rbInfo->writeOffset))
+    {
+        EPRINT("write cursor does not follow the last record: [expectedOffset=%lu], [writeOffset=%lu]", expectedOffset,
+               rbInfo->writeOffset);
+        return c_FALSE;
+    }
+
+    if ((rbInfo->nextSeq - rbInfo->oldestSeq) != recordCnt)
+    {
+        EPRINT("record count mismatch: [records=%lu], [oldestSeq=%lu], [nextSeq=%lu]", recordCnt, rbInfo->oldestSeq,
+               rbInfo->nextSeq);
+        return c_FALSE;
+    }
+
+    if (retainedCnt != rbInfo->retainCount)
+    {
+        EPRINT("retained record count mismatch: [retained=%lu], [retainCount=%lu]", retainedCnt, rbInfo->retainCount);
+        return c_FALSE;
+    }
+
+    if ((rbInfo->pubSeq < rbInfo->oldestSeq) || (rbInfo->pubSeq > rbInfo->nextSeq))
+    {
+        EPRINT("published sequence out of range: [pubSeq=%lu]", rbInfo->pubSeq);
+        return c_FALSE;
+    }
+
+    return c_TRUE;
 }
 
 /*****************************************************************************
@@ -10,6 +10,146 @@
  *****************************************************************************/
 #include "common_stddef.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*****************************************************************************
+ * ENUMS
+ *****************************************************************************/
+/**
+ * @brief Policies used to pick the next ready buffer.
+ */
+typedef enum
+{
+    Rb_SchedPolicy_ROUND_ROBIN,      /**< Visit ready buffers one pick each in handle order */
+    Rb_SchedPolicy_WEIGHTED_FAIR,    /**< Give each ready buffer up to its weight consecutive picks */
+
+} Rb_SchedPolicy_e;
+
+/**
+ * @brief Modes of per-record checksum verification.
+ */
+typedef enum
+{
+    Rb_IntegrityMode_NONE,              /**< No checksum is computed */
+    Rb_IntegrityMode_VERIFY_ON_PEEK,    /**< Checksum is verified by every peek read */
+    Rb_IntegrityMode_VERIFY_ON_DEMAND,  /**< Checksum is verified only when the consumer calls Rb_VerifyRead */
+
+} Rb_IntegrityMode_e;
+
+/**
+ * @brief Codecs applied to records on write.
+ */
+typedef enum
+{
+    Rb_Codec_NONE,                      /**< Records are stored as written */
+    Rb_Codec_LZ,                        /**< Records are LZ compressed, incompressible ones are stored raw */
+
+} Rb_Codec_e;
+
+/**
+ * @brief Occupancy watermarks of a buffer.
+ */
+typedef enum
+{
+    Rb_Watermark_HIGH,                  /**< Occupancy rose to the high watermark */
+    Rb_Watermark_LOW,                   /**< Occupancy fell back to the low watermark */
+
+} Rb_Watermark_e;
+
+/**
+ * @brief Policies used to pick the priority lane served by peek read.
+ */
+typedef enum
+{
+    Rb_LanePolicy_STRICT,               /**< Always serve the highest non-empty lane */
+    Rb_LanePolicy_WEIGHTED,             /**< Serve lanes by priority, each up to its weight picks per round */
+
+} Rb_LanePolicy_e;
+
+/**
+ * @brief Policies used when a record does not fit between the writer and the end of the buffer.
+ */
+typedef enum
+{
+    Rb_WrapPolicy_SPLIT,                /**< Split the record across the end, peek reassembles it with a copy */
+    Rb_WrapPolicy_PAD,                  /**< Leave the tail unused and place the whole record at the beginning */
+
+} Rb_WrapPolicy_e;
+
+/*****************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/**
+ * @brief Callback invoked when the occupancy of a buffer crosses a watermark.
+ * @param bufferHandle Handle of the buffer.
+ * @param watermark Watermark that was crossed.
+ * @param occupiedBytes Unread bytes in the buffer at the time of crossing.
+ * @param userData User data given with the watermarks.
+ */
+typedef void (*Rb_WatermarkCb_t)(cI32_t bufferHandle, Rb_Watermark_e watermark, cU64_t occupiedBytes, void *userData);
+
+/**
+ * @brief Independent instance of the module with its own handle table, scheduler and allocator.
+ */
+typedef struct Rb_Context Rb_Context_t;
+
+/*****************************************************************************
+ * STRUCTURES
+ *****************************************************************************/
+/**
+ * @brief Cumulative statistics of a buffer, summed over all of its lanes.
+ */
+typedef struct
+{
+    cU64_t fragmentedRecords;           /**< Records split across the end of the buffer */
+    cU64_t paddedRecords;               /**< Records moved to the beginning of the buffer, leaving padding */
+    cU64_t paddingBytes;                /**< Bytes left unused at the end of the buffer by padding */
+    cU64_t skippedRecords;              /**< Records consumed by the tag filter without being read */
+    cU64_t throttledRecords;            /**< Writes rejected by the rate limit */
+    cU64_t expiredRecords;              /**< Records consumed unread after their time to live */
+
+} Rb_Stats_t;
+
+/**
+ * @brief Allocator used for all memory of a buffer. Sizes and alignment are passed back on realloc and free,
+ *        so pool allocators do not need to keep headers.
+ */
+typedef struct
+{
+    void *(*allocFn)(cSize_t size, cSize_t alignment, void *context);   /**< Allocate aligned memory */
+    void *(*reallocFn)(void *ptr, cSize_t oldSize, cSize_t newSize, cSize_t alignment, void *context); /**< Resize memory */
+    void  (*freeFn)(void *ptr, cSize_t size, void *context);            /**< Free memory */
+    void   *context;                                                    /**< User context passed to every call */
+
+} Rb_Allocator_t;
+
+/**
+ * @brief Resolved buffer handle. It is checked against the generation of the handle slot on every call,
+ *        so a reference to a destroyed buffer is rejected even if the slot is reused.
+ */
+typedef struct
+{
+    void  *info;            /**< Control block of the buffer, owned by the library */
+    cI32_t bufferHandle;    /**< Handle the reference was acquired for */
+    cU32_t generation;      /**< Generation of the handle slot when the reference was acquired */
+
+} Rb_Ref_t;
+
+/**
+ * @brief Write rate limit of a lane, one token bucket per quantity. A rate of 0 does not limit that quantity,
+ *        a burst of 0 defaults to one second worth of the rate.
+ */
+typedef struct
+{
+    cU64_t bytesPerSec;     /**< Record bytes per second, counted before encoding */
+    cU64_t burstBytes;      /**< Bytes that may be written at once after being idle */
+    cU64_t recordsPerSec;   /**< Records per second */
+    cU64_t burstRecords;    /**< Records that may be written at once after being idle */
+
+} Rb_RateLimit_t;
+
 /*****************************************************************************
  * FUNCTION DECLARATIONS
  *****************************************************************************/
@@ -19,6 +159,26 @@ void Rb_DeinitModule(void);
 
 cBool Rb_CreateBuffer(cU64_t bufferSizeInBytes, cI32_t *bufferHandle);
 
+cBool Rb_CreateBufferWithAllocator(cU64_t bufferSizeInBytes, const Rb_Allocator_t *allocator, cI32_t *bufferHandle);
+
+cBool Rb_SetModuleAllocator(const Rb_Allocator_t *allocator);
+
+/** Context APIs */
+cBool Rb_CreateContext(const Rb_Allocator_t *allocator, Rb_Context_t **context);
+
+cBool Rb_DestroyContext(Rb_Context_t **context);
+
+cBool Rb_CtxCreateBuffer(Rb_Context_t *context, cU64_t bufferSizeInBytes, const Rb_Allocator_t *allocator,
+                         cI32_t *bufferHandle);
+
+cBool Rb_CtxSetAllocator(Rb_Context_t *context, const Rb_Allocator_t *allocator);
+
+cBool Rb_CtxSetSchedPolicy(Rb_Context_t *context, Rb_SchedPolicy_e policy);
+
+cU32_t Rb_CtxGetReadyBuffers(Rb_Context_t *context, cI32_t *bufferHandles, cU32_t maxHandles);
+
+cBool Rb_CtxGetNextReadyBuffer(Rb_Context_t *context, cI32_t *bufferHandle);
+
 cBool Rb_DestroyBuffer(cI32_t *bufferHandle);
 
 cU64_t Rb_GetUnreadIndexCount(cI32_t bufferHandle);
@@ -32,6 +192,120 @@ cBool Rb_PeekRead(cI32_t bufferHandle, cU8_t **readPtr, cU64_t *dataBytes);
 
 cBool Rb_CommitRead(cI32_t bufferHandle, cU64_t dataBytes);
 
+cBool Rb_SetPrefetchDepth(cI32_t bufferHandle, cU32_t prefetchDepth);
+
+cBool Rb_TrimMemory(cI32_t bufferHandle);
+
+/** Resolved handle APIs */
+cBool Rb_Acquire(cI32_t bufferHandle, Rb_Ref_t *ref);
+
+cBool Rb_Release(Rb_Ref_t *ref);
+
+cBool Rb_RefWriteToBuffer(const Rb_Ref_t *ref, const cU8_t *data, cU64_t dataBytes);
+
+cBool Rb_RefPeekRead(const Rb_Ref_t *ref, cU8_t **readPtr, cU64_t *dataBytes);
+
+cBool Rb_RefCommitRead(const Rb_Ref_t *ref, cU64_t dataBytes);
+
+/** Tagged record APIs */
+cBool Rb_WriteTaggedToBuffer(cI32_t bufferHandle, cU8_t tag, const cU8_t *data, cU64_t dataBytes);
+
+cBool Rb_WriteTaggedToLane(cI32_t bufferHandle, cU32_t laneId, cU8_t tag, cU32_t userWord, const cU8_t *data,
+                           cU64_t dataBytes);
+
+cBool Rb_SetTagFilter(cI32_t bufferHandle, cU64_t tagFilter);
+
+cBool Rb_GetPeekTag(cI32_t bufferHandle, cU8_t *tag);
+
+cBool Rb_GetPeekUserWord(cI32_t bufferHandle, cU32_t *userWord);
+
+/** Copy read APIs */
+cBool Rb_ReadToBuffer(cI32_t bufferHandle, cU8_t *outBuf, cU64_t outBufSize, cU64_t *dataBytes);
+
+/** Wrap policy and statistics APIs */
+cBool Rb_SetWrapPolicy(cI32_t bufferHandle, Rb_WrapPolicy_e wrapPolicy);
+
+cBool Rb_SetCompactOnEmpty(cI32_t bufferHandle, cBool compactF);
+
+cBool Rb_GetStats(cI32_t bufferHandle, Rb_Stats_t *stats);
+
+/** Priority lane APIs */
+cBool Rb_SetLanes(cI32_t bufferHandle, cU32_t laneCnt, cU64_t laneSizeInBytes, Rb_LanePolicy_e lanePolicy);
+
+cBool Rb_SetLaneWeight(cI32_t bufferHandle, cU32_t laneId, cU32_t weight);
+
+cBool Rb_WriteToLane(cI32_t bufferHandle, cU32_t laneId, const cU8_t *data, cU64_t dataSize);
+
+/** Backpressure APIs */
+cBool Rb_SetWatermarks(cI32_t bufferHandle, cU64_t highBytes, cU64_t lowBytes, Rb_WatermarkCb_t callback, void *userData);
+
+cBool Rb_IsAboveHighWatermark(cI32_t bufferHandle, cBool *aboveF);
+
+/** Rate limit APIs */
+cBool Rb_SetRateLimit(cI32_t bufferHandle, cU32_t laneId, const Rb_RateLimit_t *rateLimit);
+
+cBool Rb_GetWriteStatus(cI32_t bufferHandle, cU32_t laneId, cStatus_e *status);
+
+/** Cursor publication APIs */
+cBool Rb_SetPublishBatch(cI32_t bufferHandle, cU32_t publishRecords, cU64_t publishBytes);
+
+cBool Rb_SetReleaseBatch(cI32_t bufferHandle, cU32_t releaseRecords);
+
+cBool Rb_Flush(cI32_t bufferHandle);
+
+/** Write group APIs */
+cBool Rb_BeginWriteGroup(cI32_t bufferHandle);
+
+cBool Rb_AppendToWriteGroup(cI32_t bufferHandle, const cU8_t *data, cU64_t dataBytes);
+
+cBool Rb_PublishWriteGroup(cI32_t bufferHandle);
+
+cBool Rb_AbortWriteGroup(cI32_t bufferHandle);
+
+/** Record codec APIs */
+cBool Rb_SetCodec(cI32_t bufferHandle, Rb_Codec_e codec);
+
+/** Record sequence and replay APIs */
+cBool Rb_PeekAt(cI32_t bufferHandle, cU64_t sequence, cU8_t **readPtr, cU64_t *dataBytes);
+
+cBool Rb_GetPeekSequence(cI32_t bufferHandle, cU64_t *sequence);
+
+cBool Rb_GetSequenceRange(cI32_t bufferHandle, cU64_t *oldestSeq, cU64_t *nextSeq);
+
+cBool Rb_SetRetention(cI32_t bufferHandle, cU64_t retainRecords);
+
+/** Record time stamp APIs */
+cBool Rb_SetTimeStamping(cI32_t bufferHandle, cBool timeStampF);
+
+cU64_t Rb_GetTimeNs(void);
+
+cBool Rb_GetPeekTimeStamp(cI32_t bufferHandle, cU64_t *timeStampNs);
+
+cBool Rb_SeekToTime(cI32_t bufferHandle, cU64_t timeStampNs);
+
+cBool Rb_SetTimeToLive(cI32_t bufferHandle, cU64_t ttlNs);
+
+/** Record integrity APIs */
+cBool Rb_SetIntegrityMode(cI32_t bufferHandle, Rb_IntegrityMode_e integrityMode);
+
+cBool Rb_VerifyRead(cI32_t bufferHandle, const cU8_t *readPtr, cU64_t dataBytes);
+
+/** Diagnostic APIs */
+cBool Rb_CheckConsistency(cI32_t bufferHandle);
+
+/** Ready buffer scheduling APIs */
+cBool Rb_SetSchedPolicy(Rb_SchedPolicy_e policy);
+
+cBool Rb_SetSchedWeight(cI32_t bufferHandle, cU32_t weight);
+
+cU32_t Rb_GetReadyBuffers(cI32_t *bufferHandles, cU32_t maxHandles);
+
+cBool Rb_GetNextReadyBuffer(cI32_t *bufferHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
 /*****************************************************************************
  * @END OF FILE
  *****************************************************************************/
@@ -0,0 +1,1069 @@
+/*****************************************************************************
+ * @file    feature_checks.c
+ * @author  Kshitij Mistry
+ * @brief   Single threaded behavior checks of the buffer features.
+ *
+ * Each check drives one feature through its public API on buffers of its own and compares what the library
+ * does with what the feature documents, for the features the stress test and the fuzz target do not reach:
+ * ready buffer scheduling, peeks of compressed records, seeks by time and watermark hysteresis, also
+ * across a drain and summed over priority lanes, allocator balance, contexts, stale references, the write
+ * rate limit and record expiry. Every check
+ * destroys its buffers, so the checks do not see each other's state and can run in any order.
+ *
+ * Rejected writes print library errors, which are expected here and discarded unless -v is given.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ringBuffer.h"
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** Size of the buffers of the checks */
+#define CHECK_BUFFER_BYTES  (1000)
+
+/** Size of the records of the checks */
+#define CHECK_RECORD_BYTES  (100)
+
+/** Size of the records of the codec check, half noise and half zeros so LZ stores about half */
+#define CHECK_CODEC_BYTES   (400)
+
+/** Number of records written by the seek check, one per millisecond */
+#define CHECK_SEEK_RECORDS  (5)
+
+/** Number of live blocks a counting allocator can track */
+#define CHECK_ALLOC_BLOCKS  (64)
+
+/** Number of buffers picked from by the scheduler check */
+#define CHECK_SCHED_BUFFERS (3)
+
+/** Time to live of the expiry check, long against scheduling delays between the writes and the peek */
+#define CHECK_TTL_NS        (200 * 1000 * 1000)
+
+/** Wait of the expiry check that ages the first records, twice the time to live */
+#define CHECK_TTL_WAIT_US   (400 * 1000)
+
+/** Abort the run with the failed check, printed to stdout as library prints may be discarded */
+#define FEATURE_CHECK(cond)                                                                         \
+    do                                                                                              \
+    {                                                                                               \
+        if (!(cond))                                                                                \
+        {                                                                                           \
+            failCheck(#cond, __LINE__);                                                             \
+        }                                                                                           \
+    } while (0)
+
+/*****************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+typedef struct
+{
+    const char *name;               /**< Check name in the report */
+    void (*runFn)(void);            /**< Function running the check, failed checks abort */
+
+} Feature_Check_t;
+
+typedef struct
+{
+    cI32_t bufferHandle;            /**< Buffer of the last callback */
+    cU32_t highCnt;                 /**< High watermark crossings seen */
+    cU32_t lowCnt;                  /**< Low watermark crossings seen */
+    cU64_t occupiedBytes;           /**< Occupancy passed to the last callback */
+
+} Watermark_Events_t;
+
+typedef struct
+{
+    void  *ptr;                     /**< Live block, NULL if the entry is free */
+    cSize_t size;                   /**< Size the block was allocated or last resized with */
+
+} Alloc_Block_t;
+
+typedef struct
+{
+    Alloc_Block_t block[CHECK_ALLOC_BLOCKS]; /**< Live blocks, to check the sizes passed back on resize and free */
+    cU32_t        allocCnt;         /**< Allocations */
+    cU32_t        reallocCnt;       /**< Resizes */
+    cU32_t        freeCnt;          /**< Frees */
+    cU32_t        sizeMismatchCnt;  /**< Resizes and frees passing another size or an unknown block */
+    cU64_t        liveBytes;        /**< Bytes allocated and not yet freed */
+
+} Alloc_Counter_t;
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+static void failCheck(const char *cond, int line);
+
+static void writeRecords(cI32_t bufferHandle, cU32_t recordCnt);
+
+static void fillCodecRecord(cU8_t *record, cU32_t seed);
+
+static void countWatermark(cI32_t bufferHandle, Rb_Watermark_e watermark, cU64_t occupiedBytes, void *userData);
+
+static void readRecords(cI32_t bufferHandle, cU32_t recordCnt);
+
+static Alloc_Block_t *findBlock(Alloc_Counter_t *counter, const void *ptr);
+
+static void *countingAlloc(cSize_t size, cSize_t alignment, void *context);
+
+static void *countingRealloc(void *ptr, cSize_t oldSize, cSize_t newSize, cSize_t alignment, void *context);
+
+static void countingFree(void *ptr, cSize_t size, void *context);
+
+static cBool isAllocBalanced(const Alloc_Counter_t *counter);
+
+static void checkScheduler(void);
+
+static void checkCodecPeek(void);
+
+static void checkSeekToTime(void);
+
+static void checkWatermarks(void);
+
+static void checkDrainWatermarks(void);
+
+static void checkLaneWatermarks(void);
+
+static void checkAllocator(void);
+
+static void checkContexts(void);
+
+static void checkStaleRef(void);
+
+static void checkRateLimit(void);
+
+static void checkLaneExpiry(void);
+
+/*****************************************************************************
+ * VARIABLES
+ *****************************************************************************/
+static const Feature_Check_t gChecks[] = {
+    {"scheduler", checkScheduler},
+    {"codec peek", checkCodecPeek},
+    {"seek to time", checkSeekToTime},
+    {"watermarks", checkWatermarks},
+    {"drain watermarks", checkDrainWatermarks},
+    {"lane watermarks", checkLaneWatermarks},
+    {"allocator", checkAllocator},
+    {"contexts", checkContexts},
+    {"stale ref", checkStaleRef},
+    {"rate limit", checkRateLimit},
+    {"lane expiry", checkLaneExpiry},
+}; /**< Checks run by the test */
+
+static int gStderrFd = -1; /**< Original stderr while library prints are discarded, -1 if they are not */
+
+static const char *gCheckName = ""; /**< Name of the running check, for failure reports */
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Run every check.
+ * @param argc Number of arguments.
+ * @param argv [-v]
+ * @return int Returns 0 if every check passed, failed checks abort.
+ */
+int main(int argc, char *argv[])
+{
+    cU32_t checkId;
+    int    option;
+    cBool  verboseF = c_FALSE;
+
+    while ((option = getopt(argc, argv, "v")) != -1)
+    {
+        switch (option)
+        {
+            case 'v':
+                verboseF = c_TRUE;
+                break;
+
+            default:
+                printf("usage: %s [-v]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (verboseF == c_FALSE)
+    {
+        // Rejected writes are part of the checks and print an error each
+        gStderrFd = dup(STDERR_FILENO);
+        if ((gStderrFd < 0) || (freopen("/dev/null", "w", stderr) == NULL))
+        {
+            return 1;
+        }
+    }
+
+    Rb_InitModule();
+
+    for (checkId = 0; checkId < (sizeof(gChecks) / sizeof(gChecks[0])); checkId++)
+    {
+        gCheckName = gChecks[checkId].name;
+        gChecks[checkId].runFn();
+        printf("%-20s ok\n", gCheckName);
+    }
+
+    Rb_DeinitModule();
+    printf("all checks passed\n");
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Report a failed check and abort, restoring the library error prints first.
+ * @param cond Text of the failed condition.
+ * @param line Line of the check.
+ */
+static void failCheck(const char *cond, int line)
+{
+    printf("feature check failed: %s [check=%s], [line=%d]\n", cond, gCheckName, line);
+    fflush(stdout);
+
+    if (gStderrFd >= 0)
+    {
+        fflush(stderr);
+        dup2(gStderrFd, STDERR_FILENO);
+    }
+
+    abort();
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Write records of CHECK_RECORD_BYTES to lane 0 of the buffer, each filled with its number.
+ * @param bufferHandle Handle of the buffer.
+ * @param recordCnt Number of records to write, all must be accepted.
+ */
+static void writeRecords(cI32_t bufferHandle, cU32_t recordCnt)
+{
+    cU8_t  record[CHECK_RECORD_BYTES];
+    cU32_t recordId;
+
+    for (recordId = 0; recordId < recordCnt; recordId++)
+    {
+        memset(record, (int)recordId, sizeof(record));
+        FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_TRUE);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Read records of up to CHECK_RECORD_BYTES from the buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @param recordCnt Number of records to read, all must be available.
+ */
+static void readRecords(cI32_t bufferHandle, cU32_t recordCnt)
+{
+    cU8_t  readData[CHECK_RECORD_BYTES];
+    cU64_t dataBytes;
+    cU32_t recordId;
+
+    for (recordId = 0; recordId < recordCnt; recordId++)
+    {
+        FEATURE_CHECK(Rb_ReadToBuffer(bufferHandle, readData, sizeof(readData), &dataBytes) == c_TRUE);
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Count the watermark crossings of a buffer.
+ * @param bufferHandle Handle of the buffer.
+ * @param watermark Watermark crossed.
+ * @param occupiedBytes Occupancy at the crossing.
+ * @param userData Pointer to the Watermark_Events_t of the check.
+ */
+static void countWatermark(cI32_t bufferHandle, Rb_Watermark_e watermark, cU64_t occupiedBytes, void *userData)
+{
+    Watermark_Events_t *events = (Watermark_Events_t *)userData;
+
+    events->bufferHandle = bufferHandle;
+    events->occupiedBytes = occupiedBytes;
+    if (watermark == Rb_Watermark_HIGH)
+    {
+        events->highCnt++;
+    }
+    else
+    {
+        events->lowCnt++;
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Find the tracked entry of a block.
+ * @param counter Counter tracking the blocks.
+ * @param ptr Block to find, NULL to find a free entry.
+ * @return Alloc_Block_t* Returns the entry, or NULL if there is none.
+ */
+static Alloc_Block_t *findBlock(Alloc_Counter_t *counter, const void *ptr)
+{
+    cU32_t blockId;
+
+    for (blockId = 0; blockId < CHECK_ALLOC_BLOCKS; blockId++)
+    {
+        if (counter->block[blockId].ptr == ptr)
+        {
+            return &counter->block[blockId];
+        }
+    }
+
+    return NULL;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Allocate aligned heap memory and count it.
+ * @param size Size in bytes.
+ * @param alignment Alignment in bytes.
+ * @param context Pointer to the Alloc_Counter_t of the allocator.
+ * @return void* Returns the memory, or NULL on failure.
+ */
+static void *countingAlloc(cSize_t size, cSize_t alignment, void *context)
+{
+    Alloc_Counter_t *counter = (Alloc_Counter_t *)context;
+    Alloc_Block_t   *pBlock = findBlock(counter, NULL);
+    void            *pMemory = NULL;
+
+    if (alignment < sizeof(void *))
+    {
+        alignment = sizeof(void *);
+    }
+
+    if ((pBlock == NULL) || (posix_memalign(&pMemory, alignment, (size == 0) ? 1 : size) != 0))
+    {
+        return NULL;
+    }
+
+    pBlock->ptr = pMemory;
+    pBlock->size = size;
+    counter->allocCnt++;
+    counter->liveBytes += size;
+    return pMemory;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Resize counted memory, checking the size passed back against the one it was allocated with.
+ * @param ptr Memory to resize.
+ * @param oldSize Size the library believes the memory has.
+ * @param newSize New size in bytes.
+ * @param alignment Alignment in bytes.
+ * @param context Pointer to the Alloc_Counter_t of the allocator.
+ * @return void* Returns the resized memory, or NULL on failure with the old memory untouched.
+ */
+static void *countingRealloc(void *ptr, cSize_t oldSize, cSize_t newSize, cSize_t alignment, void *context)
+{
+    Alloc_Counter_t *counter = (Alloc_Counter_t *)context;
+    Alloc_Block_t   *pBlock;
+    void            *pMemory;
+
+    if (ptr == NULL)
+    {
+        // Scratch memory starts out empty and is grown from nothing
+        counter->sizeMismatchCnt += (oldSize != 0) ? 1 : 0;
+        return countingAlloc(newSize, alignment, context);
+    }
+
+    pBlock = findBlock(counter, ptr);
+    if ((pBlock == NULL) || (pBlock->size != oldSize))
+    {
+        counter->sizeMismatchCnt++;
+        return NULL;
+    }
+
+    // Fresh block keeps the alignment, the old one is released as a free would
+    pMemory = countingAlloc(newSize, alignment, context);
+    if (pMemory == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(pMemory, ptr, (oldSize < newSize) ? oldSize : newSize);
+    free(ptr);
+    pBlock->ptr = NULL;
+    counter->allocCnt--;
+    counter->reallocCnt++;
+    counter->liveBytes -= oldSize;
+    return pMemory;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Free counted memory, checking the size passed back against the one it was allocated with.
+ * @param ptr Memory to free.
+ * @param size Size the library believes the memory has.
+ * @param context Pointer to the Alloc_Counter_t of the allocator.
+ */
+static void countingFree(void *ptr, cSize_t size, void *context)
+{
+    Alloc_Counter_t *counter = (Alloc_Counter_t *)context;
+    Alloc_Block_t   *pBlock = findBlock(counter, ptr);
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    if ((pBlock == NULL) || (pBlock->size != size))
+    {
+        counter->sizeMismatchCnt++;
+        return;
+    }
+
+    free(ptr);
+    pBlock->ptr = NULL;
+    counter->freeCnt++;
+    counter->liveBytes -= size;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that every counted allocation was freed with the size it was allocated or resized with.
+ * @param counter Counter of the allocator.
+ * @return cBool Returns c_TRUE if the allocator is balanced, otherwise c_FALSE
+ */
+static cBool isAllocBalanced(const Alloc_Counter_t *counter)
+{
+    return ((counter->allocCnt == counter->freeCnt) && (counter->liveBytes == 0) && (counter->sizeMismatchCnt == 0))
+               ? c_TRUE
+               : c_FALSE;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Fill a record of CHECK_CODEC_BYTES with noise in its first half and zeros in the second.
+ * @param record Pointer to the record.
+ * @param seed Seed of the noise.
+ */
+static void fillCodecRecord(cU8_t *record, cU32_t seed)
+{
+    cU32_t byteId;
+    cU32_t state = seed;
+
+    for (byteId = 0; byteId < (CHECK_CODEC_BYTES / 2); byteId++)
+    {
+        state = (state * 1103515245u) + 12345u;
+        record[byteId] = (cU8_t)(state >> 24);
+    }
+
+    memset(record + (CHECK_CODEC_BYTES / 2), 0, CHECK_CODEC_BYTES / 2);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that round-robin gives every ready buffer one pick per round, that weighted-fair gives each
+ *        its weight in picks, and that a drained buffer is no longer picked.
+ */
+static void checkScheduler(void)
+{
+    cI32_t bufferHandle[CHECK_SCHED_BUFFERS], readyHandle[CHECK_SCHED_BUFFERS + 1];
+    cU32_t pickCnt[CHECK_SCHED_BUFFERS] = {0};
+    cU32_t weight[CHECK_SCHED_BUFFERS] = {3, 1, 2};
+    cU32_t bufferId, pickId;
+    cI32_t pickedHandle;
+    cU8_t  readData[CHECK_RECORD_BYTES];
+    cU64_t dataBytes;
+
+    for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+    {
+        FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle[bufferId]) == c_TRUE);
+        FEATURE_CHECK(Rb_SetSchedWeight(bufferHandle[bufferId], weight[bufferId]) == c_TRUE);
+    }
+
+    FEATURE_CHECK(Rb_GetNextReadyBuffer(&pickedHandle) == c_FALSE);
+
+    for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+    {
+        writeRecords(bufferHandle[bufferId], 1);
+    }
+
+    FEATURE_CHECK(Rb_GetReadyBuffers(readyHandle, CHECK_SCHED_BUFFERS + 1) == CHECK_SCHED_BUFFERS);
+    for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+    {
+        FEATURE_CHECK(readyHandle[bufferId] == bufferHandle[bufferId]);
+    }
+
+    // Picks do not read, so all buffers stay ready and two rounds split the picks by weight exactly
+    FEATURE_CHECK(Rb_SetSchedPolicy(Rb_SchedPolicy_WEIGHTED_FAIR) == c_TRUE);
+    for (pickId = 0; pickId < (2 * (3 + 1 + 2)); pickId++)
+    {
+        FEATURE_CHECK(Rb_GetNextReadyBuffer(&pickedHandle) == c_TRUE);
+        for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+        {
+            pickCnt[bufferId] += (pickedHandle == bufferHandle[bufferId]) ? 1 : 0;
+        }
+    }
+
+    for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+    {
+        FEATURE_CHECK(pickCnt[bufferId] == (2 * weight[bufferId]));
+        pickCnt[bufferId] = 0;
+    }
+
+    FEATURE_CHECK(Rb_SetSchedPolicy(Rb_SchedPolicy_ROUND_ROBIN) == c_TRUE);
+    for (pickId = 0; pickId < (2 * CHECK_SCHED_BUFFERS); pickId++)
+    {
+        FEATURE_CHECK(Rb_GetNextReadyBuffer(&pickedHandle) == c_TRUE);
+        for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+        {
+            pickCnt[bufferId] += (pickedHandle == bufferHandle[bufferId]) ? 1 : 0;
+        }
+    }
+
+    for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+    {
+        FEATURE_CHECK(pickCnt[bufferId] == 2);
+    }
+
+    // Drained buffer clears its ready bit and drops out of the rotation
+    FEATURE_CHECK(Rb_ReadToBuffer(bufferHandle[1], readData, sizeof(readData), &dataBytes) == c_TRUE);
+    for (pickId = 0; pickId < (2 * CHECK_SCHED_BUFFERS); pickId++)
+    {
+        FEATURE_CHECK(Rb_GetNextReadyBuffer(&pickedHandle) == c_TRUE);
+        FEATURE_CHECK(pickedHandle != bufferHandle[1]);
+    }
+
+    for (bufferId = 0; bufferId < CHECK_SCHED_BUFFERS; bufferId++)
+    {
+        FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle[bufferId]) == c_TRUE);
+    }
+
+    FEATURE_CHECK(Rb_GetReadyBuffers(readyHandle, CHECK_SCHED_BUFFERS + 1) == 0);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that peeks of compressed records return the record as written, contiguous or split across the
+ *        end of the buffer, with the checksum verified on the decoded bytes.
+ */
+static void checkCodecPeek(void)
+{
+    cI32_t     bufferHandle;
+    cU8_t      record[CHECK_CODEC_BYTES];
+    cU8_t     *readPtr;
+    cU64_t     dataBytes, freeSpace, oldestSeq, nextSeq;
+    Rb_Stats_t stats;
+
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SetCodec(bufferHandle, Rb_Codec_LZ) == c_TRUE);
+    FEATURE_CHECK(Rb_SetIntegrityMode(bufferHandle, Rb_IntegrityMode_VERIFY_ON_PEEK) == c_TRUE);
+    FEATURE_CHECK(Rb_SetCompactOnEmpty(bufferHandle, c_FALSE) == c_TRUE);
+
+    fillCodecRecord(record, 1);
+    FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK(Rb_GetFreeSpace(bufferHandle, &freeSpace) == c_TRUE);
+    FEATURE_CHECK(freeSpace > (CHECK_BUFFER_BYTES - sizeof(record)));
+
+    FEATURE_CHECK(Rb_GetSequenceRange(bufferHandle, &oldestSeq, &nextSeq) == c_TRUE);
+    FEATURE_CHECK(Rb_PeekAt(bufferHandle, oldestSeq, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK((dataBytes == sizeof(record)) && (memcmp(readPtr, record, sizeof(record)) == 0));
+
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK((dataBytes == sizeof(record)) && (memcmp(readPtr, record, sizeof(record)) == 0));
+    FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+
+    // Raw records move the writer close to the end, so the next compressed record is split
+    FEATURE_CHECK(Rb_SetCodec(bufferHandle, Rb_Codec_NONE) == c_TRUE);
+    writeRecords(bufferHandle, 7);
+    readRecords(bufferHandle, 7);
+
+    FEATURE_CHECK(Rb_SetCodec(bufferHandle, Rb_Codec_LZ) == c_TRUE);
+    fillCodecRecord(record, 2);
+    FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK(Rb_GetStats(bufferHandle, &stats) == c_TRUE);
+    FEATURE_CHECK(stats.fragmentedRecords == 1);
+
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK((dataBytes == sizeof(record)) && (memcmp(readPtr, record, sizeof(record)) == 0));
+    FEATURE_CHECK(Rb_CheckConsistency(bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(bufferHandle) == 0);
+    FEATURE_CHECK(Rb_CheckConsistency(bufferHandle) == c_TRUE);
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that a seek lands on the first record written at or after the given time and consumes the older
+ *        ones, that a seek past the last record leaves nothing unread, and that with lanes it covers every lane.
+ */
+static void checkSeekToTime(void)
+{
+    cI32_t bufferHandle;
+    cU8_t  record[CHECK_RECORD_BYTES];
+    cU8_t *readPtr;
+    cU64_t markNs[CHECK_SEEK_RECORDS];
+    cU64_t dataBytes, firstSeq, nextSeq, peekSeq;
+    cU32_t recordId;
+
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SeekToTime(bufferHandle, Rb_GetTimeNs()) == c_FALSE);
+    FEATURE_CHECK(Rb_SetTimeStamping(bufferHandle, c_TRUE) == c_TRUE);
+    FEATURE_CHECK(Rb_GetSequenceRange(bufferHandle, &firstSeq, &nextSeq) == c_TRUE);
+
+    // Each mark lies strictly between the stamps of the records before and after it
+    for (recordId = 0; recordId < CHECK_SEEK_RECORDS; recordId++)
+    {
+        usleep(1000);
+        markNs[recordId] = Rb_GetTimeNs();
+        usleep(1000);
+        memset(record, (int)recordId, sizeof(record));
+        FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_TRUE);
+    }
+
+    // Nothing is older than the first mark, so the reader stays
+    FEATURE_CHECK(Rb_SeekToTime(bufferHandle, markNs[0]) == c_TRUE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(bufferHandle) == CHECK_SEEK_RECORDS);
+
+    FEATURE_CHECK(Rb_SeekToTime(bufferHandle, markNs[2]) == c_TRUE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(bufferHandle) == (CHECK_SEEK_RECORDS - 2));
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK(Rb_GetPeekSequence(bufferHandle, &peekSeq) == c_TRUE);
+    FEATURE_CHECK((peekSeq == (firstSeq + 2)) && (readPtr[0] == 2));
+
+    // Reader may not move under an outstanding peek
+    FEATURE_CHECK(Rb_SeekToTime(bufferHandle, markNs[3]) == c_FALSE);
+    FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+
+    FEATURE_CHECK(Rb_SeekToTime(bufferHandle, Rb_GetTimeNs()) == c_TRUE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(bufferHandle) == 0);
+    FEATURE_CHECK(Rb_CheckConsistency(bufferHandle) == c_TRUE);
+
+    // With lanes every lane is searched, and a peek on any lane holds the seek
+    FEATURE_CHECK(Rb_SetLanes(bufferHandle, 2, CHECK_BUFFER_BYTES, Rb_LanePolicy_STRICT) == c_TRUE);
+    writeRecords(bufferHandle, 1);
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+    usleep(1000);
+    markNs[0] = Rb_GetTimeNs();
+    usleep(1000);
+    memset(record, 0x77, sizeof(record));
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK(Rb_SeekToTime(bufferHandle, markNs[0]) == c_FALSE);
+    FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+
+    FEATURE_CHECK(Rb_SeekToTime(bufferHandle, markNs[0]) == c_TRUE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(bufferHandle) == 1);
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK((dataBytes == sizeof(record)) && (memcmp(readPtr, record, sizeof(record)) == 0));
+    FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(bufferHandle) == 0);
+    FEATURE_CHECK(Rb_CheckConsistency(bufferHandle) == c_TRUE);
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that each watermark fires once per crossing and that nothing fires between them, in either
+ *        direction, while the polled flag follows the callbacks.
+ */
+static void checkWatermarks(void)
+{
+    cI32_t             bufferHandle;
+    cBool              aboveF;
+    Watermark_Events_t events = {0};
+
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SetWatermarks(bufferHandle, 600, 600, countWatermark, &events) == c_FALSE);
+    FEATURE_CHECK(Rb_SetWatermarks(bufferHandle, CHECK_BUFFER_BYTES + 1, 200, countWatermark, &events) == c_FALSE);
+    FEATURE_CHECK(Rb_SetWatermarks(bufferHandle, 600, 200, countWatermark, &events) == c_TRUE);
+
+    writeRecords(bufferHandle, 5);
+    FEATURE_CHECK((events.highCnt == 0) && (events.lowCnt == 0));
+
+    writeRecords(bufferHandle, 1);
+    FEATURE_CHECK((events.highCnt == 1) && (events.bufferHandle == bufferHandle) && (events.occupiedBytes == 600));
+    FEATURE_CHECK((Rb_IsAboveHighWatermark(bufferHandle, &aboveF) == c_TRUE) && (aboveF == c_TRUE));
+
+    // Between the watermarks nothing fires, going down or back up
+    writeRecords(bufferHandle, 1);
+    readRecords(bufferHandle, 4);
+    writeRecords(bufferHandle, 1);
+    FEATURE_CHECK((events.highCnt == 1) && (events.lowCnt == 0));
+    FEATURE_CHECK((Rb_IsAboveHighWatermark(bufferHandle, &aboveF) == c_TRUE) && (aboveF == c_TRUE));
+
+    readRecords(bufferHandle, 2);
+    FEATURE_CHECK((events.lowCnt == 1) && (events.occupiedBytes == 200));
+    FEATURE_CHECK((Rb_IsAboveHighWatermark(bufferHandle, &aboveF) == c_TRUE) && (aboveF == c_FALSE));
+
+    // Writer wraps on the way back up, the occupancy still counts both sides
+    writeRecords(bufferHandle, 3);
+    FEATURE_CHECK(events.highCnt == 1);
+    writeRecords(bufferHandle, 1);
+    FEATURE_CHECK((events.highCnt == 2) && (events.lowCnt == 1) && (events.occupiedBytes == 600));
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that a drained buffer counts as empty for the watermarks, also the tail the writer skips when it
+ *        starts the next lap, and that the hysteresis keeps working across the drain.
+ */
+static void checkDrainWatermarks(void)
+{
+    cI32_t             bufferHandle;
+    cBool              aboveF;
+    cU64_t             freeSpace;
+    Watermark_Events_t events = {0};
+
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+
+    // Drain leaves the writer at 900 bytes, the next write skips the tail which must not read as occupied
+    writeRecords(bufferHandle, 9);
+    readRecords(bufferHandle, 9);
+    FEATURE_CHECK((Rb_GetFreeSpace(bufferHandle, &freeSpace) == c_TRUE) && (freeSpace == CHECK_BUFFER_BYTES));
+    FEATURE_CHECK(Rb_SetWatermarks(bufferHandle, 800, 100, countWatermark, &events) == c_TRUE);
+    FEATURE_CHECK((events.highCnt == 0) && (events.lowCnt == 0));
+    FEATURE_CHECK((Rb_IsAboveHighWatermark(bufferHandle, &aboveF) == c_TRUE) && (aboveF == c_FALSE));
+
+    writeRecords(bufferHandle, 8);
+    FEATURE_CHECK((events.highCnt == 1) && (events.occupiedBytes == 800));
+
+    readRecords(bufferHandle, 7);
+    FEATURE_CHECK((events.lowCnt == 1) && (events.occupiedBytes == 100));
+
+    // Draining below the low watermark fires nothing more, refilling after the drain fires high once again
+    readRecords(bufferHandle, 1);
+    writeRecords(bufferHandle, 7);
+    FEATURE_CHECK((events.highCnt == 1) && (events.lowCnt == 1));
+    writeRecords(bufferHandle, 1);
+    FEATURE_CHECK((events.highCnt == 2) && (events.lowCnt == 1) && (events.occupiedBytes == 800));
+    FEATURE_CHECK((Rb_IsAboveHighWatermark(bufferHandle, &aboveF) == c_TRUE) && (aboveF == c_TRUE));
+    FEATURE_CHECK(Rb_CheckConsistency(bufferHandle) == c_TRUE);
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that with priority lanes the watermarks see the occupancy summed over all lanes, fired by writes
+ *        and reads on any lane and reported for the buffer handle.
+ */
+static void checkLaneWatermarks(void)
+{
+    cI32_t             bufferHandle;
+    cU8_t              record[CHECK_RECORD_BYTES];
+    cBool              aboveF;
+    cU32_t             recordId;
+    Watermark_Events_t events = {0};
+
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SetLanes(bufferHandle, 2, CHECK_BUFFER_BYTES, Rb_LanePolicy_STRICT) == c_TRUE);
+
+    // High watermark may be anywhere up to the size of both lanes
+    FEATURE_CHECK(Rb_SetWatermarks(bufferHandle, (2 * CHECK_BUFFER_BYTES) + 1, 200, countWatermark, &events) == c_FALSE);
+    FEATURE_CHECK(Rb_SetWatermarks(bufferHandle, 1500, 200, countWatermark, &events) == c_TRUE);
+
+    memset(record, 0xA5, sizeof(record));
+    for (recordId = 0; recordId < 9; recordId++)
+    {
+        FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+    }
+
+    FEATURE_CHECK(events.highCnt == 0);
+
+    writeRecords(bufferHandle, 6);
+    FEATURE_CHECK((events.highCnt == 1) && (events.bufferHandle == bufferHandle) && (events.occupiedBytes == 1500));
+    FEATURE_CHECK((Rb_IsAboveHighWatermark(bufferHandle, &aboveF) == c_TRUE) && (aboveF == c_TRUE));
+
+    // Strict policy drains lane 1 first, lane 0 still holds the buffer above the low watermark
+    readRecords(bufferHandle, 9);
+    FEATURE_CHECK((events.lowCnt == 0) && (events.occupiedBytes == 1500));
+
+    readRecords(bufferHandle, 4);
+    FEATURE_CHECK((events.highCnt == 1) && (events.lowCnt == 1) && (events.occupiedBytes == 200));
+    FEATURE_CHECK((Rb_IsAboveHighWatermark(bufferHandle, &aboveF) == c_TRUE) && (aboveF == c_FALSE));
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that a buffer takes all of its memory, buffer, lanes and scratch, from its allocator, passes the
+ *        sizes back unchanged and returns every byte on trim and destroy, also through the module allocator.
+ */
+static void checkAllocator(void)
+{
+    static Alloc_Counter_t bufferCounter, moduleCounter;
+    Rb_Allocator_t         bufferAllocator = {countingAlloc, countingRealloc, countingFree, &bufferCounter};
+    Rb_Allocator_t         moduleAllocator = {countingAlloc, countingRealloc, countingFree, &moduleCounter};
+    cI32_t                 bufferHandle;
+    cU8_t                  record[CHECK_CODEC_BYTES];
+    cU8_t                 *readPtr;
+    cU64_t                 dataBytes, oldestSeq, nextSeq;
+    cU32_t                 laneId, allocCnt;
+
+    FEATURE_CHECK(Rb_CreateBufferWithAllocator(CHECK_BUFFER_BYTES, &bufferAllocator, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SetLanes(bufferHandle, 2, CHECK_BUFFER_BYTES, Rb_LanePolicy_STRICT) == c_TRUE);
+    FEATURE_CHECK(Rb_SetCodec(bufferHandle, Rb_Codec_LZ) == c_TRUE);
+    allocCnt = bufferCounter.allocCnt;
+    FEATURE_CHECK(allocCnt >= 2);
+
+    // Codec, reassembly and replay scratch memory of both lanes grow on first use
+    fillCodecRecord(record, 3);
+    for (laneId = 0; laneId < 2; laneId++)
+    {
+        FEATURE_CHECK(Rb_WriteToLane(bufferHandle, laneId, record, sizeof(record)) == c_TRUE);
+        FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+        FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+    }
+
+    FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK(Rb_GetSequenceRange(bufferHandle, &oldestSeq, &nextSeq) == c_TRUE);
+    FEATURE_CHECK(Rb_PeekAt(bufferHandle, nextSeq - 1, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK(bufferCounter.allocCnt > allocCnt);
+
+    // Trim gives all scratch memory back, only the memory of both lanes stays until the next peek
+    FEATURE_CHECK(Rb_TrimMemory(bufferHandle) == c_TRUE);
+    FEATURE_CHECK(bufferCounter.liveBytes == (2 * CHECK_BUFFER_BYTES));
+    allocCnt = bufferCounter.allocCnt;
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK((dataBytes == sizeof(record)) && (memcmp(readPtr, record, sizeof(record)) == 0));
+    FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+    FEATURE_CHECK(bufferCounter.allocCnt > allocCnt);
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+    FEATURE_CHECK(isAllocBalanced(&bufferCounter) == c_TRUE);
+
+    // Module allocator serves buffers created without their own
+    FEATURE_CHECK(Rb_SetModuleAllocator(&moduleAllocator) == c_TRUE);
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SetModuleAllocator(NULL) == c_TRUE);
+    FEATURE_CHECK(moduleCounter.allocCnt > 0);
+    writeRecords(bufferHandle, 3);
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+    FEATURE_CHECK(isAllocBalanced(&moduleCounter) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that contexts keep their buffers and ready lists apart from each other and from the default
+ *        context, and that destroying a context invalidates its handles and returns all of its memory.
+ */
+static void checkContexts(void)
+{
+    static Alloc_Counter_t contextCounter;
+    Rb_Allocator_t         contextAllocator = {countingAlloc, countingRealloc, countingFree, &contextCounter};
+    Rb_Context_t          *countedContext = NULL, *heapContext = NULL;
+    cI32_t                 countedHandle, heapHandle, readyHandle[2];
+
+    FEATURE_CHECK(Rb_CreateContext(&contextAllocator, &countedContext) == c_TRUE);
+    FEATURE_CHECK(Rb_CreateContext(NULL, &heapContext) == c_TRUE);
+    FEATURE_CHECK(countedContext != heapContext);
+
+    FEATURE_CHECK(Rb_CtxCreateBuffer(countedContext, CHECK_BUFFER_BYTES, NULL, &countedHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_CtxCreateBuffer(heapContext, CHECK_BUFFER_BYTES, NULL, &heapHandle) == c_TRUE);
+    FEATURE_CHECK(countedHandle != heapHandle);
+
+    // Ready buffer of one context is invisible to the others
+    writeRecords(countedHandle, 1);
+    FEATURE_CHECK(Rb_CtxGetReadyBuffers(countedContext, readyHandle, 2) == 1);
+    FEATURE_CHECK(readyHandle[0] == countedHandle);
+    FEATURE_CHECK(Rb_CtxGetReadyBuffers(heapContext, readyHandle, 2) == 0);
+    FEATURE_CHECK(Rb_GetReadyBuffers(readyHandle, 2) == 0);
+    FEATURE_CHECK(Rb_CtxGetNextReadyBuffer(heapContext, &readyHandle[0]) == c_FALSE);
+    FEATURE_CHECK((Rb_CtxGetNextReadyBuffer(countedContext, &readyHandle[0]) == c_TRUE) && (readyHandle[0] == countedHandle));
+
+    // Context memory and the buffers of the context come from its allocator, a destroy returns all of it
+    FEATURE_CHECK(contextCounter.allocCnt >= 2);
+    FEATURE_CHECK(Rb_DestroyContext(&countedContext) == c_TRUE);
+    FEATURE_CHECK(countedContext == NULL);
+    FEATURE_CHECK(isAllocBalanced(&contextCounter) == c_TRUE);
+    FEATURE_CHECK(Rb_WriteToBuffer(countedHandle, (const cU8_t *)"x", 1) == c_FALSE);
+    FEATURE_CHECK(Rb_DestroyContext(&countedContext) == c_FALSE);
+
+    writeRecords(heapHandle, 1);
+    readRecords(heapHandle, 1);
+    FEATURE_CHECK(Rb_DestroyContext(&heapContext) == c_TRUE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(heapHandle) == 0);
+    FEATURE_CHECK(Rb_WriteToBuffer(heapHandle, (const cU8_t *)"x", 1) == c_FALSE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that a reference to a destroyed buffer is rejected even after its slot is reused by a new buffer,
+ *        that a fresh reference to the new buffer works, that a released reference is rejected, and that a
+ *        reference kept across a module re-initialization is rejected.
+ */
+static void checkStaleRef(void)
+{
+    cI32_t   oldHandle, newHandle, staleHandle;
+    Rb_Ref_t oldRef, newRef;
+    cU8_t    record[CHECK_RECORD_BYTES];
+    cU8_t   *readPtr;
+    cU64_t   dataBytes;
+
+    memset(record, 0x5A, sizeof(record));
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &oldHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_Acquire(oldHandle, &oldRef) == c_TRUE);
+    FEATURE_CHECK(Rb_RefWriteToBuffer(&oldRef, record, sizeof(record)) == c_TRUE);
+
+    // New buffer takes the freed slot, so only the generation tells the buffers apart
+    staleHandle = oldHandle;
+    FEATURE_CHECK(Rb_DestroyBuffer(&oldHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &newHandle) == c_TRUE);
+    FEATURE_CHECK(newHandle == staleHandle);
+
+    FEATURE_CHECK(Rb_RefWriteToBuffer(&oldRef, record, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK(Rb_RefPeekRead(&oldRef, &readPtr, &dataBytes) == c_FALSE);
+    FEATURE_CHECK(Rb_RefCommitRead(&oldRef, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(newHandle) == 0);
+
+    FEATURE_CHECK(Rb_Acquire(newHandle, &newRef) == c_TRUE);
+    FEATURE_CHECK(Rb_RefWriteToBuffer(&newRef, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK(Rb_RefPeekRead(&newRef, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK((dataBytes == sizeof(record)) && (memcmp(readPtr, record, sizeof(record)) == 0));
+    FEATURE_CHECK(Rb_RefCommitRead(&newRef, dataBytes) == c_TRUE);
+
+    FEATURE_CHECK(Rb_Release(&newRef) == c_TRUE);
+    FEATURE_CHECK(Rb_RefWriteToBuffer(&newRef, record, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(newHandle) == 0);
+
+    // Module re-initialization hands out the same slot again, the reference from before must not match it
+    FEATURE_CHECK(Rb_Acquire(newHandle, &oldRef) == c_TRUE);
+    Rb_DeinitModule();
+    FEATURE_CHECK(Rb_RefWriteToBuffer(&oldRef, record, sizeof(record)) == c_FALSE);
+    Rb_InitModule();
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &newHandle) == c_TRUE);
+    FEATURE_CHECK(newHandle == staleHandle);
+
+    FEATURE_CHECK(Rb_RefWriteToBuffer(&oldRef, record, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK(Rb_RefPeekRead(&oldRef, &readPtr, &dataBytes) == c_FALSE);
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(newHandle) == 0);
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&newHandle) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that the record bucket passes a burst and throttles the next write, refills up to the burst and
+ *        no further, and that the byte bucket lets a record into debt and throttles until it is paid off. The
+ *        write status is kept per lane and set by every write.
+ */
+static void checkRateLimit(void)
+{
+    cI32_t         bufferHandle;
+    cU8_t          record[CHECK_RECORD_BYTES];
+    cStatus_e      status;
+    Rb_Stats_t     stats;
+    Rb_RateLimit_t recordLimit = {.recordsPerSec = 1, .burstRecords = 3};
+    Rb_RateLimit_t refillLimit = {.recordsPerSec = 2, .burstRecords = 2};
+    Rb_RateLimit_t byteLimit = {.bytesPerSec = 100, .burstBytes = 150};
+
+    memset(record, 0x3C, sizeof(record));
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SetRateLimit(bufferHandle, 1, &recordLimit) == c_FALSE);
+    FEATURE_CHECK(Rb_SetRateLimit(bufferHandle, 0, &recordLimit) == c_TRUE);
+
+    writeRecords(bufferHandle, 3);
+    FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK((Rb_GetWriteStatus(bufferHandle, 0, &status) == c_TRUE) && (status == cStatus_RESOURCE_BUSY));
+    FEATURE_CHECK((Rb_GetStats(bufferHandle, &stats) == c_TRUE) && (stats.throttledRecords == 1));
+
+    // One and a half seconds earn three records, the bucket keeps only the burst and the next token is half a
+    // second away, so scheduling delays stay far from both edges
+    FEATURE_CHECK(Rb_SetRateLimit(bufferHandle, 0, &refillLimit) == c_TRUE);
+    writeRecords(bufferHandle, 2);
+    usleep(1500 * 1000);
+    writeRecords(bufferHandle, 2);
+    FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK((Rb_GetStats(bufferHandle, &stats) == c_TRUE) && (stats.throttledRecords == 2));
+    FEATURE_CHECK(Rb_GetUnreadIndexCount(bufferHandle) == 7);
+
+    // Second record overdraws the 150 byte burst, the third waits one and a half seconds for the debt
+    readRecords(bufferHandle, 7);
+    FEATURE_CHECK(Rb_SetRateLimit(bufferHandle, 0, &byteLimit) == c_TRUE);
+    writeRecords(bufferHandle, 2);
+    FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK((Rb_GetStats(bufferHandle, &stats) == c_TRUE) && (stats.throttledRecords == 3));
+
+    // Removing the limit lets writes through at once, which clears the status
+    FEATURE_CHECK(Rb_SetRateLimit(bufferHandle, 0, NULL) == c_TRUE);
+    FEATURE_CHECK(Rb_WriteToBuffer(bufferHandle, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK((Rb_GetWriteStatus(bufferHandle, 0, &status) == c_TRUE) && (status == cStatus_SUCCESS));
+    FEATURE_CHECK(Rb_CheckConsistency(bufferHandle) == c_TRUE);
+
+    // Throttled lane 1 leaves lane 0 and its status alone
+    readRecords(bufferHandle, 3);
+    FEATURE_CHECK(Rb_SetLanes(bufferHandle, 2, CHECK_BUFFER_BYTES, Rb_LanePolicy_STRICT) == c_TRUE);
+    FEATURE_CHECK(Rb_SetRateLimit(bufferHandle, 1, &byteLimit) == c_TRUE);
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_FALSE);
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 0, record, sizeof(record)) == c_TRUE);
+    FEATURE_CHECK((Rb_GetWriteStatus(bufferHandle, 1, &status) == c_TRUE) && (status == cStatus_RESOURCE_BUSY));
+    FEATURE_CHECK((Rb_GetWriteStatus(bufferHandle, 0, &status) == c_TRUE) && (status == cStatus_SUCCESS));
+    FEATURE_CHECK(Rb_GetWriteStatus(bufferHandle, 2, &status) == c_FALSE);
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Check that a peek consumes the expired records of every lane and counts them once, stops at the first
+ *        fresh record, and that time stamping stays on while a time to live is set.
+ */
+static void checkLaneExpiry(void)
+{
+    cI32_t     bufferHandle;
+    cU8_t      record[CHECK_RECORD_BYTES];
+    cU8_t     *readPtr;
+    cU64_t     dataBytes;
+    cU32_t     recordId;
+    Rb_Stats_t stats;
+
+    FEATURE_CHECK(Rb_CreateBuffer(CHECK_BUFFER_BYTES, &bufferHandle) == c_TRUE);
+    FEATURE_CHECK(Rb_SetLanes(bufferHandle, 2, CHECK_BUFFER_BYTES, Rb_LanePolicy_STRICT) == c_TRUE);
+    FEATURE_CHECK(Rb_SetTimeToLive(bufferHandle, CHECK_TTL_NS) == c_FALSE);
+    FEATURE_CHECK(Rb_SetTimeStamping(bufferHandle, c_TRUE) == c_TRUE);
+    FEATURE_CHECK(Rb_SetTimeToLive(bufferHandle, CHECK_TTL_NS) == c_TRUE);
+    FEATURE_CHECK(Rb_SetTimeStamping(bufferHandle, c_FALSE) == c_FALSE);
+
+    memset(record, 0xC3, sizeof(record));
+    for (recordId = 0; recordId < 3; recordId++)
+    {
+        FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+    }
+    writeRecords(bufferHandle, 2);
+
+    // Only the record written after the wait is younger than the time to live
+    usleep(CHECK_TTL_WAIT_US);
+    memset(record, 0x77, sizeof(record));
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 0, record, sizeof(record)) == c_TRUE);
+
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_TRUE);
+    FEATURE_CHECK((dataBytes == sizeof(record)) && (memcmp(readPtr, record, sizeof(record)) == 0));
+    FEATURE_CHECK((Rb_GetStats(bufferHandle, &stats) == c_TRUE) && (stats.expiredRecords == 5));
+    FEATURE_CHECK(Rb_CommitRead(bufferHandle, dataBytes) == c_TRUE);
+
+    FEATURE_CHECK(Rb_PeekRead(bufferHandle, &readPtr, &dataBytes) == c_FALSE);
+    FEATURE_CHECK((Rb_GetStats(bufferHandle, &stats) == c_TRUE) && (stats.expiredRecords == 5));
+    FEATURE_CHECK(Rb_CheckConsistency(bufferHandle) == c_TRUE);
+
+    // Without a time to live old records are kept and stamping may be turned off again once empty
+    FEATURE_CHECK(Rb_SetTimeToLive(bufferHandle, 0) == c_TRUE);
+    FEATURE_CHECK(Rb_WriteToLane(bufferHandle, 1, record, sizeof(record)) == c_TRUE);
+    usleep(40 * 1000);
+    readRecords(bufferHandle, 1);
+    FEATURE_CHECK(Rb_SetTimeStamping(bufferHandle, c_FALSE) == c_TRUE);
+
+    FEATURE_CHECK(Rb_DestroyBuffer(&bufferHandle) == c_TRUE);
+}
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/
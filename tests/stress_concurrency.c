@@ -0,0 +1,801 @@
+/*****************************************************************************
+ * @file    stress_concurrency.c
+ * @author  Kshitij Mistry
+ * @brief   Producer/consumer stress test of the buffer modes against a reference model.
+ *
+ * Each mode configures one buffer (lanes, wrap policy, publish and release batches, codec, integrity
+ * checking, retention, write groups) and runs producer threads and one consumer thread on it. The buffer is
+ * not thread safe, so every call is serialized by one mutex, the same way bench_compare.cpp shares it; the
+ * model of each lane is updated in the same critical section as the call, so the call order under the mutex
+ * is the linearization order the model checks against.
+ *
+ * Records have random sizes and carry a header with the producer, the record number and a checksum of the
+ * payload. The consumer checks every record it reads against the oldest record of its lane in the model
+ * (producer, number, size, payload checksum, sequence number and user word), so a lost, duplicated,
+ * reordered, torn or prematurely visible record fails the run. Rb_CheckConsistency runs after every step.
+ * Both sides inject random yields and sleeps outside the lock to vary the interleaving.
+ *
+ * Without arguments every mode runs a fixed number of records, which is what ctest runs. With -s SECONDS
+ * every mode runs that long as a soak and the report shows records/s and MB/s per mode. Build with
+ * -DRB_ENABLE_TSAN=ON to run it under ThreadSanitizer. Library error prints (rejected writes of a full
+ * buffer are expected here) are discarded unless -v is given.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ringBuffer.h"
+
+/*****************************************************************************
+ * MACROS
+ *****************************************************************************/
+/** Size of each lane of the buffer under test, small so records wrap and fragment often */
+#define STRESS_LANE_BYTES       (16 * 1024)
+
+/** Largest record written */
+#define STRESS_MAX_RECORD_BYTES (2000)
+
+/** Largest number of lanes of any mode */
+#define STRESS_MAX_LANES        (3)
+
+/** Largest number of producer threads of any mode */
+#define STRESS_MAX_PRODUCERS    (3)
+
+/** Records the model of a lane can hold, above the record index limit of a lane */
+#define STRESS_MODEL_RECORDS    (1024)
+
+/** Largest number of records in one write group */
+#define STRESS_MAX_GROUP        (6)
+
+/** Records written per mode without a soak time */
+#define STRESS_QUICK_RECORDS    (20000)
+
+/** Default seed of the random sizes and pauses */
+#define STRESS_DEFAULT_SEED     (0x5eed)
+
+/** Longest injected sleep in microseconds */
+#define STRESS_MAX_SLEEP_US     (200)
+
+/** Abort the run with the failed check, printed to stdout as library prints may be discarded */
+#define STRESS_CHECK(cond)                                                                          \
+    do                                                                                              \
+    {                                                                                               \
+        if (!(cond))                                                                                \
+        {                                                                                           \
+            failRun(#cond, __LINE__);                                                               \
+        }                                                                                           \
+    } while (0)
+
+/*****************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+typedef struct
+{
+    const char        *name;            /**< Mode name in the report */
+    cU32_t             producerCnt;     /**< Number of producer threads */
+    cU32_t             laneCnt;         /**< Number of lanes of the buffer */
+    Rb_LanePolicy_e    lanePolicy;      /**< Lane policy of the buffer */
+    Rb_WrapPolicy_e    wrapPolicy;      /**< Wrap policy of the buffer */
+    cU32_t             publishRecords;  /**< Publish batch of the writer */
+    cU32_t             releaseRecords;  /**< Release batch of the reader */
+    Rb_Codec_e         codec;           /**< Record codec */
+    Rb_IntegrityMode_e integrityMode;   /**< Integrity checking mode */
+    cU64_t             retainRecords;   /**< Consumed records retained for replay */
+    cBool              groupsF;         /**< Flag to write part of the records in write groups */
+    cBool              copyReadF;       /**< Flag to read with Rb_ReadToBuffer instead of peek and commit */
+
+} Stress_Mode_t;
+
+typedef struct
+{
+    cU32_t producerId;      /**< Producer that wrote the record */
+    cU32_t checksum;        /**< Checksum of the payload following the header */
+    cU64_t recordId;        /**< Number of the record among the records of its producer */
+
+} Stress_Header_t;
+
+typedef struct
+{
+    cU32_t producerId;      /**< Producer that wrote the record */
+    cU32_t checksum;        /**< Checksum of the payload */
+    cU64_t recordId;        /**< Number of the record among the records of its producer */
+    cU64_t dataBytes;       /**< Size of the record including the header */
+    cU32_t userWord;        /**< User word of the record, 0 unless written with Rb_WriteTaggedToLane */
+
+} Stress_Expected_t;
+
+typedef struct
+{
+    Stress_Expected_t record[STRESS_MODEL_RECORDS]; /**< Unread records of the lane in write order */
+    cU64_t            head;                         /**< Position of the oldest unread record */
+    cU64_t            count;                        /**< Number of unread records */
+    cU64_t            readCnt;                      /**< Records read from the lane, the sequence of the next one */
+
+} Stress_Lane_t;
+
+typedef struct
+{
+    const Stress_Mode_t *mode;                          /**< Mode under test */
+    cI32_t               bufferHandle;                  /**< Buffer under test */
+    pthread_mutex_t      mutex;                         /**< Serializes all calls on the buffer and the model */
+    Stress_Lane_t        lane[STRESS_MAX_LANES];        /**< Model of each lane */
+    Stress_Expected_t    group[STRESS_MAX_GROUP];       /**< Records of the open write group */
+    cU32_t               groupCount;                    /**< Number of records in the open write group */
+    cBool                groupOpenF;                    /**< Flag to indicate a write group is open */
+    cU64_t               recordsPerProducer;            /**< Records each producer writes, 0 to run until the deadline */
+    cU64_t               deadlineNs;                    /**< End of a soak run */
+    cU32_t               producersDone;                 /**< Number of producers that wrote all their records */
+    cU64_t               writtenRecords;                /**< Records accepted by the buffer */
+    cU64_t               rejectedWrites;                /**< Writes rejected by a full buffer */
+    cU64_t               abortedRecords;                /**< Records dropped by an aborted write group */
+    cU64_t               readRecords;                   /**< Records read and checked by the consumer */
+    cU64_t               readBytes;                     /**< Bytes read and checked by the consumer */
+    cU64_t               replayChecks;                  /**< Retained records read back with Rb_PeekAt */
+
+} Stress_Run_t;
+
+typedef struct
+{
+    Stress_Run_t *run;          /**< Run the thread belongs to */
+    cU32_t        producerId;   /**< Producer number, unused by the consumer */
+    cU64_t        rngState;     /**< State of the random generator of the thread */
+
+} Stress_Thread_t;
+
+/*****************************************************************************
+ * VARIABLES
+ *****************************************************************************/
+static const Stress_Mode_t gModes[] = {
+    {"default", 1, 1, Rb_LanePolicy_STRICT, Rb_WrapPolicy_SPLIT, 1, 1, Rb_Codec_NONE, Rb_IntegrityMode_NONE, 0,
+     c_FALSE, c_FALSE},
+    {"pad-batched", 1, 1, Rb_LanePolicy_STRICT, Rb_WrapPolicy_PAD, 8, 4, Rb_Codec_NONE, Rb_IntegrityMode_NONE, 0,
+     c_FALSE, c_FALSE},
+    {"codec-crc-copy", 1, 1, Rb_LanePolicy_STRICT, Rb_WrapPolicy_SPLIT, 1, 1, Rb_Codec_LZ,
+     Rb_IntegrityMode_VERIFY_ON_PEEK, 0, c_FALSE, c_TRUE},
+    {"groups-retention", 1, 1, Rb_LanePolicy_STRICT, Rb_WrapPolicy_SPLIT, 1, 2, Rb_Codec_NONE, Rb_IntegrityMode_NONE,
+     16, c_TRUE, c_FALSE},
+    {"lanes-weighted", 3, 3, Rb_LanePolicy_WEIGHTED, Rb_WrapPolicy_SPLIT, 4, 1, Rb_Codec_NONE,
+     Rb_IntegrityMode_VERIFY_ON_PEEK, 0, c_FALSE, c_FALSE},
+    {"lanes-strict-copy", 2, 2, Rb_LanePolicy_STRICT, Rb_WrapPolicy_PAD, 1, 3, Rb_Codec_LZ, Rb_IntegrityMode_NONE, 0,
+     c_FALSE, c_TRUE},
+}; /**< Modes run by the test */
+
+static cU64_t gSeed = STRESS_DEFAULT_SEED; /**< Seed of the random sizes and pauses */
+
+static int gStderrFd = -1; /**< Original stderr while library prints are discarded, -1 if they are not */
+
+static const char *gModeName = ""; /**< Name of the running mode, for failure reports */
+
+/*****************************************************************************
+ * FUNCTION DECLARATIONS
+ *****************************************************************************/
+static void failRun(const char *cond, int line);
+
+static cU64_t nextRandom(cU64_t *rngState);
+
+static void injectPause(cU64_t *rngState);
+
+static cU32_t computeChecksum(const cU8_t *data, cU64_t dataBytes);
+
+static cU64_t fillRecord(cU8_t *record, Stress_Thread_t *thread, cU64_t recordId, Stress_Expected_t *expected);
+
+static void pushExpected(Stress_Lane_t *lane, const Stress_Expected_t *expected);
+
+static void checkRecord(Stress_Run_t *run, const cU8_t *readPtr, cU64_t dataBytes, cBool peekF);
+
+static void checkReplay(Stress_Run_t *run, cU64_t sequence, const Stress_Expected_t *expected);
+
+static cBool writeOneRecord(Stress_Thread_t *thread, cU64_t recordId);
+
+static cBool readOneRecord(Stress_Thread_t *thread, cU8_t *outBuf);
+
+static cU64_t getModelCount(const Stress_Run_t *run);
+
+static void *producerMain(void *arg);
+
+static void *consumerMain(void *arg);
+
+static void runMode(const Stress_Mode_t *mode, cU64_t soakNs);
+
+/*****************************************************************************
+ * FUNCTION DEFINATIONS
+ *****************************************************************************/
+//----------------------------------------------------------------------------
+/**
+ * @brief Run every mode, each for a fixed number of records or for the soak time.
+ * @param argc Number of arguments.
+ * @param argv [-s SECONDS] [-r SEED] [-v]
+ * @return int Returns 0 if every mode passed, failed checks abort.
+ */
+int main(int argc, char *argv[])
+{
+    cU64_t soakNs = 0;
+    cBool  verboseF = c_FALSE;
+    cU32_t modeId;
+    int    option;
+
+    while ((option = getopt(argc, argv, "s:r:v")) != -1)
+    {
+        switch (option)
+        {
+            case 's':
+                soakNs = strtoull(optarg, NULL, 10) * 1000000000ULL;
+                break;
+
+            case 'r':
+                gSeed = strtoull(optarg, NULL, 0);
+                break;
+
+            case 'v':
+                verboseF = c_TRUE;
+                break;
+
+            default:
+                printf("usage: %s [-s SECONDS] [-r SEED] [-v]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (verboseF == c_FALSE)
+    {
+        // Full buffers reject writes with an error print, thousands of times per mode
+        gStderrFd = dup(STDERR_FILENO);
+        if ((gStderrFd < 0) || (freopen("/dev/null", "w", stderr) == NULL))
+        {
+            return 1;
+        }
+    }
+
+    Rb_InitModule();
+
+    printf("seed 0x%lx, %s\n", gSeed, (soakNs == 0) ? "quick run" : "soak run");
+    printf("%-18s %10s %10s %9s %8s %12s %9s\n", "mode", "records", "rejected", "aborted", "replays", "records/s",
+           "MB/s");
+
+    for (modeId = 0; modeId < (sizeof(gModes) / sizeof(gModes[0])); modeId++)
+    {
+        runMode(&gModes[modeId], soakNs);
+    }
+
+    Rb_DeinitModule();
+    printf("all modes passed\n");
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Report a failed check and abort, printing the library error prints of a consistency check again.
+ * @param cond Text of the failed condition.
+ * @param line Line of the check.
+ */
+static void failRun(const char *cond, int line)
+{
+    printf("stress check failed: %s [mode=%s], [line=%d], [seed=0x%lx]\n", cond, gModeName, line, gSeed);
+    fflush(stdout);
+
+    if (gStderrFd >= 0)
+    {
+        // Let the consistency check print the violation it found
+        fflush(stderr);
+        dup2(gStderrFd, STDERR_FILENO);
+    }
+
+    abort();
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the next number of a xorshift64* generator.
+ * @param rngState State of the generator, never 0.
+ * @return cU64_t Returns a pseudo random number.
+ */
+static cU64_t nextRandom(cU64_t *rngState)
+{
+    *rngState ^= *rngState >> 12;
+    *rngState ^= *rngState << 25;
+    *rngState ^= *rngState >> 27;
+    return *rngState * 0x2545F4914F6CDD1DULL;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Sometimes yield or sleep, called outside the lock to vary the interleaving of the threads.
+ * @param rngState State of the random generator of the thread.
+ */
+static void injectPause(cU64_t *rngState)
+{
+    cU64_t          draw = nextRandom(rngState);
+    struct timespec pause;
+
+    if ((draw % 256) < 2)
+    {
+        pause.tv_sec = 0;
+        pause.tv_nsec = (long)(((draw >> 8) % STRESS_MAX_SLEEP_US) * 1000);
+        nanosleep(&pause, NULL);
+    }
+    else if ((draw % 256) < 32)
+    {
+        sched_yield();
+    }
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Compute the FNV-1a checksum of a payload.
+ * @param data Pointer to the payload.
+ * @param dataBytes Size of the payload in bytes.
+ * @return cU32_t Returns the checksum.
+ */
+static cU32_t computeChecksum(const cU8_t *data, cU64_t dataBytes)
+{
+    cU32_t checksum = 2166136261U;
+    cU64_t byteId;
+
+    for (byteId = 0; byteId < dataBytes; byteId++)
+    {
+        checksum = (checksum ^ data[byteId]) * 16777619U;
+    }
+
+    return checksum;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Build a record of random size, half of them small, with a payload the codec can compress or not.
+ * @param record Memory of the record, STRESS_MAX_RECORD_BYTES long.
+ * @param thread Producer thread writing the record.
+ * @param recordId Number of the record among the records of the producer.
+ * @param expected Pointer to store the record as the model expects it back.
+ * @return cU64_t Returns the size of the record in bytes.
+ */
+static cU64_t fillRecord(cU8_t *record, Stress_Thread_t *thread, cU64_t recordId, Stress_Expected_t *expected)
+{
+    Stress_Header_t header;
+    cU64_t          draw = nextRandom(&thread->rngState);
+    cU64_t          dataBytes, byteId;
+
+    if (draw & 1)
+    {
+        dataBytes = sizeof(header) + ((draw >> 1) % 128);
+    }
+    else
+    {
+        dataBytes = sizeof(header) + ((draw >> 1) % (STRESS_MAX_RECORD_BYTES - sizeof(header) + 1));
+    }
+
+    for (byteId = sizeof(header); byteId < dataBytes; byteId++)
+    {
+        // Every other record repeats short runs, so the codec stores some records compressed and some raw
+        record[byteId] = (draw & 2) ? (cU8_t)(recordId + (byteId / 16)) : (cU8_t)nextRandom(&thread->rngState);
+    }
+
+    header.producerId = thread->producerId;
+    header.recordId = recordId;
+    header.checksum = computeChecksum(record + sizeof(header), dataBytes - sizeof(header));
+    memcpy(record, &header, sizeof(header));
+
+    expected->producerId = header.producerId;
+    expected->recordId = header.recordId;
+    expected->checksum = header.checksum;
+    expected->dataBytes = dataBytes;
+    expected->userWord = 0;
+    return dataBytes;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Append a written record to the model of its lane.
+ * @param lane Model of the lane.
+ * @param expected Record as the model expects it back.
+ */
+static void pushExpected(Stress_Lane_t *lane, const Stress_Expected_t *expected)
+{
+    STRESS_CHECK(lane->count < STRESS_MODEL_RECORDS);
+    lane->record[(lane->head + lane->count) % STRESS_MODEL_RECORDS] = *expected;
+    lane->count++;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Compare a record read by the consumer with the oldest record of its lane in the model and remove it.
+ * @param run Run under test.
+ * @param readPtr Pointer to the record.
+ * @param dataBytes Size of the record in bytes.
+ * @param peekF c_TRUE if the record was peeked, so its sequence number can be checked too.
+ */
+static void checkRecord(Stress_Run_t *run, const cU8_t *readPtr, cU64_t dataBytes, cBool peekF)
+{
+    const Stress_Expected_t *expected;
+    Stress_Header_t          header;
+    Stress_Lane_t           *lane;
+    cU64_t                   sequence;
+    cU32_t                   userWord;
+
+    STRESS_CHECK(dataBytes >= sizeof(header));
+    memcpy(&header, readPtr, sizeof(header));
+
+    // Each producer owns a lane when there are as many lanes as producers, otherwise all write to lane 0
+    STRESS_CHECK(header.producerId < run->mode->producerCnt);
+    lane = &run->lane[(run->mode->laneCnt > 1) ? header.producerId : 0];
+
+    STRESS_CHECK(lane->count > 0);
+    expected = &lane->record[lane->head];
+    STRESS_CHECK(header.producerId == expected->producerId);
+    STRESS_CHECK(header.recordId == expected->recordId);
+    STRESS_CHECK(dataBytes == expected->dataBytes);
+    STRESS_CHECK(header.checksum == expected->checksum);
+    STRESS_CHECK(computeChecksum(readPtr + sizeof(header), dataBytes - sizeof(header)) == expected->checksum);
+
+    if (peekF == c_TRUE)
+    {
+        // Aborted groups give their sequence numbers back, so the records read are numbered without gaps
+        STRESS_CHECK(Rb_GetPeekSequence(run->bufferHandle, &sequence) == c_TRUE);
+        STRESS_CHECK(sequence == lane->readCnt);
+        STRESS_CHECK(Rb_GetPeekUserWord(run->bufferHandle, &userWord) == c_TRUE);
+        STRESS_CHECK(userWord == expected->userWord);
+    }
+
+    lane->head = (lane->head + 1) % STRESS_MODEL_RECORDS;
+    lane->count--;
+    lane->readCnt++;
+    run->readRecords++;
+    run->readBytes += dataBytes;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Read a consumed record back by its sequence number, if it is still retained.
+ * @param run Run under test.
+ * @param sequence Sequence number of the record.
+ * @param expected Record as it was read.
+ */
+static void checkReplay(Stress_Run_t *run, cU64_t sequence, const Stress_Expected_t *expected)
+{
+    Stress_Header_t header;
+    cU64_t          oldestSeq, nextSeq, dataBytes;
+    cU8_t          *readPtr;
+
+    STRESS_CHECK(Rb_GetSequenceRange(run->bufferHandle, &oldestSeq, &nextSeq) == c_TRUE);
+    if (sequence < oldestSeq)
+    {
+        // Retention is best effort, the writer reclaimed it
+        return;
+    }
+
+    STRESS_CHECK(Rb_PeekAt(run->bufferHandle, sequence, &readPtr, &dataBytes) == c_TRUE);
+    STRESS_CHECK(dataBytes == expected->dataBytes);
+    memcpy(&header, readPtr, sizeof(header));
+    STRESS_CHECK(header.recordId == expected->recordId);
+    STRESS_CHECK(computeChecksum(readPtr + sizeof(header), dataBytes - sizeof(header)) == expected->checksum);
+    run->replayChecks++;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Write one record as the producer, opening, publishing and aborting write groups at random.
+ * @param thread Producer thread.
+ * @param recordId Number of the record among the records of the producer.
+ * @return cBool Returns c_TRUE if the record was accepted, otherwise c_FALSE as the buffer was full.
+ */
+static cBool writeOneRecord(Stress_Thread_t *thread, cU64_t recordId)
+{
+    cU8_t                 record[STRESS_MAX_RECORD_BYTES];
+    Stress_Run_t         *run = thread->run;
+    Stress_Expected_t     expected;
+    cU64_t                dataBytes = fillRecord(record, thread, recordId, &expected);
+    cU64_t                draw = nextRandom(&thread->rngState);
+    cU32_t                laneId = (run->mode->laneCnt > 1) ? thread->producerId : 0;
+    cU32_t                recordIdx;
+    cStatus_e             status;
+    cBool                 writtenF;
+
+    pthread_mutex_lock(&run->mutex);
+
+    if ((run->mode->groupsF == c_TRUE) && (run->groupOpenF == c_FALSE) && ((draw % 4) == 0))
+    {
+        STRESS_CHECK(Rb_BeginWriteGroup(run->bufferHandle) == c_TRUE);
+        run->groupOpenF = c_TRUE;
+        run->groupCount = 0;
+    }
+
+    if (run->groupOpenF == c_TRUE)
+    {
+        writtenF = Rb_AppendToWriteGroup(run->bufferHandle, record, dataBytes);
+    }
+    else if ((run->mode->laneCnt > 1) && ((draw >> 24) & 1))
+    {
+        // Half of the lane records carry the record number as user word in their index entry
+        expected.userWord = (cU32_t)recordId + 1;
+        writtenF = Rb_WriteTaggedToLane(run->bufferHandle, laneId, 0, expected.userWord, record, dataBytes);
+    }
+    else if (run->mode->laneCnt > 1)
+    {
+        writtenF = Rb_WriteToLane(run->bufferHandle, laneId, record, dataBytes);
+    }
+    else
+    {
+        writtenF = Rb_WriteToBuffer(run->bufferHandle, record, dataBytes);
+    }
+
+    // Group records always go to lane 0
+    STRESS_CHECK(Rb_GetWriteStatus(run->bufferHandle, (run->groupOpenF == c_TRUE) ? 0 : laneId, &status) == c_TRUE);
+
+    if (writtenF == c_TRUE)
+    {
+        STRESS_CHECK(status == cStatus_SUCCESS);
+        run->writtenRecords++;
+        if (run->groupOpenF == c_TRUE)
+        {
+            run->group[run->groupCount++] = expected;
+        }
+        else
+        {
+            pushExpected(&run->lane[laneId], &expected);
+        }
+    }
+    else
+    {
+        STRESS_CHECK(status == cStatus_NO_RESOURCE);
+        run->rejectedWrites++;
+
+        // Records waiting for their publish batch may be what fills the buffer
+        STRESS_CHECK(Rb_Flush(run->bufferHandle) == c_TRUE);
+    }
+
+    if ((run->groupOpenF == c_TRUE) &&
+        ((writtenF == c_FALSE) || (run->groupCount == STRESS_MAX_GROUP) || (((draw >> 8) % 3) == 0)))
+    {
+        run->groupOpenF = c_FALSE;
+        if (((draw >> 16) % 4) == 0)
+        {
+            STRESS_CHECK(Rb_AbortWriteGroup(run->bufferHandle) == c_TRUE);
+            run->writtenRecords -= run->groupCount;
+            run->abortedRecords += run->groupCount;
+        }
+        else
+        {
+            STRESS_CHECK(Rb_PublishWriteGroup(run->bufferHandle) == c_TRUE);
+            for (recordIdx = 0; recordIdx < run->groupCount; recordIdx++)
+            {
+                pushExpected(&run->lane[0], &run->group[recordIdx]);
+            }
+        }
+    }
+
+    STRESS_CHECK(Rb_CheckConsistency(run->bufferHandle) == c_TRUE);
+    pthread_mutex_unlock(&run->mutex);
+
+    return writtenF;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Read and check one record as the consumer, flushing the batches when nothing is visible.
+ * @param thread Consumer thread.
+ * @param outBuf Memory for copy reads, STRESS_MAX_RECORD_BYTES long.
+ * @return cBool Returns c_TRUE if the consumer is done: all producers finished and everything was read.
+ */
+static cBool readOneRecord(Stress_Thread_t *thread, cU8_t *outBuf)
+{
+    Stress_Run_t     *run = thread->run;
+    Stress_Expected_t lastRead;
+    cU8_t            *readPtr;
+    cU64_t            dataBytes, sequence = 0, attempt;
+    cBool             readF = c_FALSE, doneF;
+
+    pthread_mutex_lock(&run->mutex);
+
+    // A second attempt after a flush must find any record the model holds, even one held back by a batch
+    for (attempt = 0; (attempt < 2) && (readF == c_FALSE); attempt++)
+    {
+        if (attempt == 1)
+        {
+            STRESS_CHECK(Rb_Flush(run->bufferHandle) == c_TRUE);
+        }
+
+        if (run->mode->copyReadF == c_TRUE)
+        {
+            readF = Rb_ReadToBuffer(run->bufferHandle, outBuf, STRESS_MAX_RECORD_BYTES, &dataBytes);
+            if (readF == c_TRUE)
+            {
+                checkRecord(run, outBuf, dataBytes, c_FALSE);
+            }
+        }
+        else
+        {
+            readF = Rb_PeekRead(run->bufferHandle, &readPtr, &dataBytes);
+            if (readF == c_TRUE)
+            {
+                if (run->mode->retainRecords != 0)
+                {
+                    STRESS_CHECK(Rb_GetPeekSequence(run->bufferHandle, &sequence) == c_TRUE);
+                    memcpy(&lastRead, &run->lane[0].record[run->lane[0].head], sizeof(lastRead));
+                }
+
+                checkRecord(run, readPtr, dataBytes, c_TRUE);
+                STRESS_CHECK(Rb_CommitRead(run->bufferHandle, dataBytes) == c_TRUE);
+
+                if ((run->mode->retainRecords != 0) && ((nextRandom(&thread->rngState) % 8) == 0))
+                {
+                    checkReplay(run, sequence, &lastRead);
+                }
+            }
+        }
+
+        STRESS_CHECK(Rb_CheckConsistency(run->bufferHandle) == c_TRUE);
+    }
+
+    if (readF == c_FALSE)
+    {
+        // Outside of an open write group every record in the model is published after a flush
+        STRESS_CHECK(getModelCount(run) == 0);
+    }
+
+    doneF = ((readF == c_FALSE) && (run->producersDone == run->mode->producerCnt)) ? c_TRUE : c_FALSE;
+    pthread_mutex_unlock(&run->mutex);
+
+    return doneF;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Get the number of unread records in the model over all lanes.
+ * @param run Run under test.
+ * @return cU64_t Returns the number of records.
+ */
+static cU64_t getModelCount(const Stress_Run_t *run)
+{
+    cU64_t recordCnt = 0;
+    cU32_t laneId;
+
+    for (laneId = 0; laneId < STRESS_MAX_LANES; laneId++)
+    {
+        recordCnt += run->lane[laneId].count;
+    }
+
+    return recordCnt;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Producer thread: write records until the record count or the deadline is reached.
+ * @param arg Producer thread state.
+ * @return void* Returns NULL.
+ */
+static void *producerMain(void *arg)
+{
+    Stress_Thread_t *thread = (Stress_Thread_t *)arg;
+    Stress_Run_t    *run = thread->run;
+    cU64_t           recordId = 0;
+    cU32_t           recordIdx;
+
+    while (((run->recordsPerProducer != 0) && (recordId < run->recordsPerProducer)) ||
+           ((run->recordsPerProducer == 0) && (Rb_GetTimeNs() < run->deadlineNs)))
+    {
+        if (writeOneRecord(thread, recordId) == c_TRUE)
+        {
+            recordId++;
+        }
+        else
+        {
+            // Full, give the consumer a turn
+            sched_yield();
+        }
+
+        injectPause(&thread->rngState);
+    }
+
+    pthread_mutex_lock(&run->mutex);
+    if (run->groupOpenF == c_TRUE)
+    {
+        // Last records of the producer are in a group, make them readable
+        STRESS_CHECK(Rb_PublishWriteGroup(run->bufferHandle) == c_TRUE);
+        for (recordIdx = 0; recordIdx < run->groupCount; recordIdx++)
+        {
+            pushExpected(&run->lane[0], &run->group[recordIdx]);
+        }
+        run->groupOpenF = c_FALSE;
+    }
+    run->producersDone++;
+    pthread_mutex_unlock(&run->mutex);
+
+    return NULL;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Consumer thread: read and check records until the producers are done and everything is read.
+ * @param arg Consumer thread state.
+ * @return void* Returns NULL.
+ */
+static void *consumerMain(void *arg)
+{
+    static cU8_t     outBuf[STRESS_MAX_RECORD_BYTES];
+    Stress_Thread_t *thread = (Stress_Thread_t *)arg;
+
+    while (readOneRecord(thread, outBuf) == c_FALSE)
+    {
+        injectPause(&thread->rngState);
+    }
+
+    return NULL;
+}
+
+//----------------------------------------------------------------------------
+/**
+ * @brief Run one mode: configure a buffer, run the threads to completion and report the throughput.
+ * @param mode Mode to run.
+ * @param soakNs Soak time in nanoseconds, 0 to write a fixed number of records.
+ */
+static void runMode(const Stress_Mode_t *mode, cU64_t soakNs)
+{
+    static Stress_Run_t run;
+    Stress_Thread_t     producer[STRESS_MAX_PRODUCERS], consumer;
+    pthread_t           producerThread[STRESS_MAX_PRODUCERS], consumerThread;
+    cU64_t              startNs, elapsedNs;
+    cU32_t              threadId;
+
+    gModeName = mode->name;
+    memset(&run, 0, sizeof(run));
+    run.mode = mode;
+    run.recordsPerProducer = (soakNs == 0) ? (STRESS_QUICK_RECORDS / mode->producerCnt) : 0;
+    pthread_mutex_init(&run.mutex, NULL);
+
+    STRESS_CHECK(Rb_CreateBuffer(STRESS_LANE_BYTES, &run.bufferHandle) == c_TRUE);
+    STRESS_CHECK(Rb_SetLanes(run.bufferHandle, mode->laneCnt, STRESS_LANE_BYTES, mode->lanePolicy) == c_TRUE);
+    for (threadId = 1; threadId < mode->laneCnt; threadId++)
+    {
+        STRESS_CHECK(Rb_SetLaneWeight(run.bufferHandle, threadId, threadId + 1) == c_TRUE);
+    }
+    STRESS_CHECK(Rb_SetWrapPolicy(run.bufferHandle, mode->wrapPolicy) == c_TRUE);
+    STRESS_CHECK(Rb_SetPublishBatch(run.bufferHandle, mode->publishRecords, 0) == c_TRUE);
+    STRESS_CHECK(Rb_SetReleaseBatch(run.bufferHandle, mode->releaseRecords) == c_TRUE);
+    STRESS_CHECK(Rb_SetCodec(run.bufferHandle, mode->codec) == c_TRUE);
+    STRESS_CHECK(Rb_SetIntegrityMode(run.bufferHandle, mode->integrityMode) == c_TRUE);
+    STRESS_CHECK(Rb_SetRetention(run.bufferHandle, mode->retainRecords) == c_TRUE);
+
+    startNs = Rb_GetTimeNs();
+    run.deadlineNs = startNs + soakNs;
+
+    consumer.run = &run;
+    consumer.producerId = 0;
+    consumer.rngState = gSeed ^ 0x9E3779B97F4A7C15ULL;
+    STRESS_CHECK(pthread_create(&consumerThread, NULL, consumerMain, &consumer) == 0);
+
+    for (threadId = 0; threadId < mode->producerCnt; threadId++)
+    {
+        producer[threadId].run = &run;
+        producer[threadId].producerId = threadId;
+        producer[threadId].rngState = gSeed + ((cU64_t)(threadId + 1) << 32);
+        STRESS_CHECK(pthread_create(&producerThread[threadId], NULL, producerMain, &producer[threadId]) == 0);
+    }
+
+    for (threadId = 0; threadId < mode->producerCnt; threadId++)
+    {
+        pthread_join(producerThread[threadId], NULL);
+    }
+    pthread_join(consumerThread, NULL);
+    elapsedNs = Rb_GetTimeNs() - startNs;
+
+    STRESS_CHECK(run.readRecords == run.writtenRecords);
+    STRESS_CHECK(Rb_GetUnreadIndexCount(run.bufferHandle) == 0);
+    STRESS_CHECK(Rb_DestroyBuffer(&run.bufferHandle) == c_TRUE);
+    pthread_mutex_destroy(&run.mutex);
+
+    printf("%-18s %10lu %10lu %9lu %8lu %12.0f %9.1f\n", mode->name, run.readRecords, run.rejectedWrites,
+           run.abortedRecords, run.replayChecks, (double)run.readRecords * 1e9 / (double)elapsedNs,
+           (double)run.readBytes * 1e3 / (double)elapsedNs);
+    fflush(stdout);
+}
+
+/*****************************************************************************
+ * @END OF FILE
+ *****************************************************************************/